@@ -0,0 +1,537 @@
+#ifndef __BINOMIAL_HEAP_H__
+#define __BINOMIAL_HEAP_H__
+
+#include <cstdlib>
+#include <type_traits>
+#include <utility>
+#include "NodePool.h"
+
+template<class T>
+struct BinomialHeapNode
+{
+	BinomialHeapNode *right;
+	// The parent for the leftmost child of a node, the sibling on the left
+	// for its other children and NULL for a root. Following it from any node
+	// of a tree ends at the root of the tree.
+	BinomialHeapNode *parent;
+	BinomialHeapNode *leftmostChild;
+	T key;
+
+	// The key is constructed in place from args.
+	template<class... Args>
+	explicit BinomialHeapNode(Args&&... args)
+		: key(std::forward<Args>(args)...)
+	{
+		right = NULL;
+		parent = NULL;
+		leftmostChild = NULL;
+	}
+};
+
+template<class T, template <class> class Allocator = NodePool>
+class BinomialHeap
+{
+private:
+	// The root of the heap. Should be kept NULL all the time the heap is empty
+	BinomialHeapNode<T> *root;
+	// The number of elements currently stored in the heap.
+	int size;
+	// the key of the minimal element currently stored in the heap
+	BinomialHeapNode<T> *min_element;
+	// Allocator owning the nodes of the heap
+	Allocator<BinomialHeapNode<T> > allocator;
+	// Mergest two binomial trees with equal degree
+	BinomialHeapNode<T> *mergeTree(BinomialHeapNode<T> *leftTree, BinomialHeapNode<T> *rightTree);
+	// Destroys all nodes currently stored in the heap
+	void deleteNodes();
+	// Does the work of consolidate. The root skipped (if not NULL) is part of
+	// the left list but not counted in leftSize, and is left out of the
+	// result. minimum receives the root of the result with the smallest key.
+	BinomialHeapNode<T> *mergeRootLists(BinomialHeapNode<T> *leftRoot, int leftSize,
+		BinomialHeapNode<T> *rightRoot, int rightSize, BinomialHeapNode<T> *skipped, BinomialHeapNode<T> *&minimum);
+	// The parent of a node, or NULL for a root.
+	static BinomialHeapNode<T> *getParent(BinomialHeapNode<T> *node);
+	// Exchanges the places of a node and its parent in the tree by relinking
+	// them, so neither key is moved.
+	void swapWithParent(BinomialHeapNode<T> *node, BinomialHeapNode<T> *parent);
+	// Moves a node whose key was just decreased up to its place.
+	void siftUp(BinomialHeapNode<T> *node);
+	// Builds the binomial trees for the keys in [first, last) directly and
+	// returns their root list. count and minimum receive the number of keys
+	// and the root holding the smallest one.
+	template <class InputIterator>
+	BinomialHeapNode<T> *buildTrees(InputIterator first, InputIterator last, int &count, BinomialHeapNode<T> *&minimum);
+
+	BinomialHeap(const BinomialHeap&);
+	BinomialHeap& operator=(const BinomialHeap&);
+
+protected:
+	/**
+	* Auxiliary function to be used when uniting two heaps.
+	*
+	* This function should merge the two given root lists in the root list of a
+	* single binomial heap - the result of the merging.
+	*
+	* This method is virtual for ease of testing. Still you need to implement it.
+	*
+	* |NOTE| This method could have been static as long as it will not access any
+	* |NOTE| of the fields of the class. Still it is not static, because in some
+	* |NOTE| of the tests it will be overridden.
+	*
+	* @param leftRoot - the first node of the root list of the first heap
+	* @param leftSize - the number of the elements in the left heap
+	* @param rightRoot - the first node of the root list of the second heap
+	* @param rightSize - the number of the elements in the right heap
+	* @return the first node of the root list of the binomial heap result of
+	*		the merging of the two given heaps
+	*/
+	virtual BinomialHeapNode<T>* consolidate(BinomialHeapNode<T>* leftRoot, int leftSize,
+		BinomialHeapNode<T>* rightRoot, int rightSize);
+public:
+	/**
+	* Construct empty binomial heap
+	*/
+	BinomialHeap();
+
+	/**
+	* Construct heap with the given elements.
+	* Expected runneing time O(elementsSize)
+	* @param elements - array containing the elements
+	* @param elementsSize - the number of elements in the array
+	*/
+	BinomialHeap(T elements[], int elementsSize);
+
+	/**
+	* Frees all nodes of the heap. With a pooling allocator the nodes are
+	* released in bulk instead of one by one.
+	*/
+	~BinomialHeap();
+
+	/**
+	* @return - the key of the minimal element currently stored in the heap
+	*/
+	const T& getMin() const;
+
+	/**
+	* @return - the root of the heap. Will be used for testing purposes.
+	*/
+	BinomialHeapNode<T>* getRoot() const;
+
+	/**
+	* @return - the number of the elements currently stored in the heap.
+	*/
+	int getSize() const;
+
+	/**
+	* @return - the number of requests the heap made to the system allocator.
+	*/
+	long long getAllocationCount() const;
+
+	/**
+	* @return - the largest number of bytes of node memory the heap has held.
+	*/
+	long long getPeakNodeMemory() const;
+
+	/**
+	* Extracts (removes) the element with minimal key from the heap
+	* @return - the key of the minimal element currently stored in the heap,
+	*		moved out of its node
+	*/
+	T extractMin();
+
+	/**
+	* Unites the current heap with the one given.
+	* It is expected that the structure of otherHeap will be destroyed in this method.
+	*
+	* @param otherHeap - the heap with which we will unite. It will be destroyed in this method
+	*/
+	void unite(BinomialHeap<T, Allocator>& otherHeap);
+
+	/**
+	* Inserts element with the new given key in the heap.
+	* @param newKey - the key of the element to be inserted
+	* @return a pointer to the newly created element in the heap
+	*/
+	BinomialHeapNode<T>* push(const T& newKey);
+
+	/**
+	* Inserts element with the given key in the heap, moving the key into it.
+	* @param newKey - the key of the element to be inserted
+	* @return a pointer to the newly created element in the heap
+	*/
+	BinomialHeapNode<T>* push(T&& newKey);
+
+	/**
+	* Inserts element with a key constructed in place from the given arguments.
+	* @param args - the arguments passed to the constructor of the key
+	* @return a pointer to the newly created element in the heap
+	*/
+	template <class... Args>
+	BinomialHeapNode<T>* emplace(Args&&... args);
+
+	/**
+	* Inserts all keys in the range [first, last) in the heap.
+	* The new keys are laid out as binomial trees in O(k) and merged with the
+	* heap in a single consolidate pass, instead of one pass per key.
+	* @param first - iterator to the first key to be inserted
+	* @param last - iterator past the last key to be inserted
+	*/
+	template <class InputIterator>
+	void pushRange(InputIterator first, InputIterator last);
+
+	/**
+	* Decreases the key of the given element to the given amount.
+	* It is guaranteed the ptr is real pointer to element of the heap.
+	* The node is moved up by relinking it with its ancestors, so ptr and all
+	* other pointers returned by push keep pointing at their own keys.
+	* WARNING!!!
+	*       No changes should be made if the newly given key is larger than
+	*       the current value of the key.
+	* WARNING!!!
+	*
+	* @param ptr - a pointer to the element which key is to be modified
+	* @param newKey - the new value of the key to be used for element pointed by ptr
+	*/
+	void decreaseKey(BinomialHeapNode<T>* ptr, const T& newKey);
+
+	/**
+	* Same as decreaseKey for T = Prioritized<Priority, Payload>, but only the
+	* priority is changed and the payload stays where it is.
+	*
+	* @param ptr - a pointer to the element which priority is to be modified
+	* @param newPriority - the new priority of the element pointed by ptr
+	*/
+	template <class Priority>
+	void decreasePriority(BinomialHeapNode<T>* ptr, const Priority& newPriority);
+};
+
+template <class T, template <class> class Allocator> BinomialHeapNode<T> *BinomialHeap<T, Allocator>::mergeTree(BinomialHeapNode<T> *leftRoot, BinomialHeapNode<T> *rightRoot)
+{
+	if (!(leftRoot->key < rightRoot->key))
+		std::swap(leftRoot, rightRoot);
+	if (leftRoot->leftmostChild != NULL)
+		leftRoot->leftmostChild->parent = rightRoot;
+	rightRoot->parent = leftRoot;
+	rightRoot->right = leftRoot->leftmostChild;
+	leftRoot->leftmostChild = rightRoot;
+	return leftRoot;
+}
+
+template <class T, template <class> class Allocator> BinomialHeapNode<T> *BinomialHeap<T, Allocator>::consolidate(BinomialHeapNode<T> *leftRoot, int leftSize, BinomialHeapNode<T> *rightRoot, int rightSize)
+{
+	BinomialHeapNode<T> *minimum;
+	return mergeRootLists(leftRoot, leftSize, rightRoot, rightSize, NULL, minimum);
+}
+
+template <class T, template <class> class Allocator> BinomialHeapNode<T> *BinomialHeap<T, Allocator>::mergeRootLists(BinomialHeapNode<T> *leftRoot, int leftSize,
+	BinomialHeapNode<T> *rightRoot, int rightSize, BinomialHeapNode<T> *skipped, BinomialHeapNode<T> *&minimum)
+{
+	// Adds the two root lists like binary numbers: bit k of a size tells
+	// whether the list holds a tree of degree k, carry holds the tree of
+	// degree k produced by merging two trees of degree k - 1.
+	BinomialHeapNode<T> *head = NULL, *tail = NULL, *carry = NULL, *trees[3], *next;
+	int count;
+	minimum = NULL;
+	while (leftSize != 0 || rightSize != 0 || carry != NULL)
+	{
+		count = 0;
+		if ((leftSize & 1) == 1)
+		{
+			if (leftRoot == skipped)
+				leftRoot = leftRoot->right;
+			trees[count++] = leftRoot;
+			leftRoot = leftRoot->right;
+		}
+		if ((rightSize & 1) == 1)
+		{
+			trees[count++] = rightRoot;
+			rightRoot = rightRoot->right;
+		}
+		if (carry != NULL)
+			trees[count++] = carry;
+		leftSize >>= 1;
+		rightSize >>= 1;
+		next = NULL;
+		carry = NULL;
+		if (count == 1)
+			next = trees[0];
+		else if (count == 2)
+			carry = mergeTree(trees[0], trees[1]);
+		else if (count == 3)
+		{
+			next = trees[2];
+			carry = mergeTree(trees[0], trees[1]);
+		}
+		if (next != NULL)
+		{
+			if (tail == NULL)
+				head = next;
+			else
+				tail->right = next;
+			tail = next;
+			if (minimum == NULL || minimum->key > next->key)
+				minimum = next;
+		}
+	}
+	if (tail != NULL)
+		tail->right = NULL;
+	return head;
+}
+
+template <class T, template <class> class Allocator> BinomialHeap<T, Allocator>::BinomialHeap()
+{
+	root = NULL;
+	size = 0;
+	min_element = NULL;
+}
+
+template <class T, template <class> class Allocator> BinomialHeap<T, Allocator>::BinomialHeap(T elements[], int elementsSize)
+{
+	root = buildTrees(elements, elements + elementsSize, size, min_element);
+}
+
+template <class T, template <class> class Allocator> template <class InputIterator>
+BinomialHeapNode<T> *BinomialHeap<T, Allocator>::buildTrees(InputIterator first, InputIterator last, int &count, BinomialHeapNode<T> *&minimum)
+{
+	// trees[k] is the pending tree of degree k. Adding a key works like
+	// incrementing a binary counter, so all keys are linked in O(count).
+	BinomialHeapNode<T> *trees[32], *current, *head = NULL;
+	int degree;
+	for (degree = 0; degree < 32; degree++)
+		trees[degree] = NULL;
+	count = 0;
+	for (; first != last; ++first)
+	{
+		current = allocator.allocate(*first);
+		for (degree = 0; trees[degree] != NULL; degree++)
+		{
+			current = mergeTree(trees[degree], current);
+			trees[degree] = NULL;
+		}
+		trees[degree] = current;
+		count++;
+	}
+	minimum = NULL;
+	for (degree = 31; degree >= 0; degree--)
+		if (trees[degree] != NULL)
+		{
+			trees[degree]->right = head;
+			head = trees[degree];
+			if (minimum == NULL || minimum->key > head->key)
+				minimum = head;
+		}
+	return head;
+}
+
+template <class T, template <class> class Allocator> BinomialHeap<T, Allocator>::~BinomialHeap()
+{
+	if (!Allocator<BinomialHeapNode<T> >::releases_in_bulk || !std::is_trivially_destructible<T>::value)
+		deleteNodes();
+}
+
+template <class T, template <class> class Allocator> void BinomialHeap<T, Allocator>::deleteNodes()
+{
+	BinomialHeapNode<T> *current = root, *temp;
+	// Walks the child/sibling tree by rotating children into the root list,
+	// so no recursion or extra memory is needed.
+	while (current != NULL)
+	{
+		if (current->leftmostChild != NULL)
+		{
+			temp = current->leftmostChild;
+			current->leftmostChild = temp->right;
+			temp->right = current;
+			current = temp;
+		}
+		else
+		{
+			temp = current->right;
+			allocator.deallocate(current);
+			current = temp;
+		}
+	}
+	root = NULL;
+	min_element = NULL;
+	size = 0;
+}
+
+template <class T, template <class> class Allocator> const T &BinomialHeap<T, Allocator>::getMin() const
+{
+	return min_element->key;
+}
+
+template <class T, template <class> class Allocator> BinomialHeapNode<T> *BinomialHeap<T, Allocator>::getRoot() const
+{
+	return root;
+}
+
+template <class T, template <class> class Allocator> int BinomialHeap<T, Allocator>::getSize() const
+{
+	return size;
+}
+
+template <class T, template <class> class Allocator> long long BinomialHeap<T, Allocator>::getAllocationCount() const
+{
+	return allocator.getAllocationCount();
+}
+
+template <class T, template <class> class Allocator> long long BinomialHeap<T, Allocator>::getPeakNodeMemory() const
+{
+	return allocator.getPeakBytes();
+}
+
+template <class T, template <class> class Allocator> T BinomialHeap<T, Allocator>::extractMin()
+{
+	BinomialHeapNode<T> *current = min_element->leftmostChild, *children = NULL, *next;
+	int degree = 0;
+	T result = std::move(min_element->key);
+	// The children are ordered by decreasing degree; reversing them gives a
+	// root list that can be merged with the remaining roots.
+	while (current != NULL)
+	{
+		next = current->right;
+		current->right = children;
+		current->parent = NULL;
+		children = current;
+		current = next;
+		degree++;
+	}
+	size -= 1 << degree;
+	root = mergeRootLists(root, size, children, (1 << degree) - 1, min_element, next);
+	allocator.deallocate(min_element);
+	size += (1 << degree) - 1;
+	min_element = next;
+	return result;
+}
+
+template <class T, template <class> class Allocator> void BinomialHeap<T, Allocator>::unite(BinomialHeap<T, Allocator>& otherHeap)
+{
+	root = consolidate(root, size, otherHeap.root, otherHeap.size);
+	size += otherHeap.size;
+	allocator.adopt(otherHeap.allocator);
+	if (min_element == NULL || (otherHeap.min_element != NULL && min_element->key > otherHeap.min_element->key))
+		min_element = otherHeap.min_element;
+	// On equal keys mergeTree may have hung the minimum below a root with the same key.
+	if (min_element != NULL)
+		while (min_element->parent != NULL)
+			min_element = min_element->parent;
+	otherHeap.root = NULL;
+	otherHeap.size = 0;
+	otherHeap.min_element = NULL;
+}
+
+template <class T, template <class> class Allocator> BinomialHeapNode<T> *BinomialHeap<T, Allocator>::push(const T &newKey)
+{
+	return emplace(newKey);
+}
+
+template <class T, template <class> class Allocator> BinomialHeapNode<T> *BinomialHeap<T, Allocator>::push(T &&newKey)
+{
+	return emplace(std::move(newKey));
+}
+
+template <class T, template <class> class Allocator> template <class... Args>
+BinomialHeapNode<T> *BinomialHeap<T, Allocator>::emplace(Args&&... args)
+{
+	BinomialHeapNode <T> *new_node = allocator.allocate(std::forward<Args>(args)...);
+	BinomialHeap<T, Allocator> new_binomial_heap;
+	new_binomial_heap.root = new_node;
+	new_binomial_heap.size = 1;
+	new_binomial_heap.min_element = new_node;
+	unite(new_binomial_heap);
+	return new_node;
+}
+
+template <class T, template <class> class Allocator> template <class InputIterator>
+void BinomialHeap<T, Allocator>::pushRange(InputIterator first, InputIterator last)
+{
+	BinomialHeap<T, Allocator> new_binomial_heap;
+	new_binomial_heap.root = buildTrees(first, last, new_binomial_heap.size, new_binomial_heap.min_element);
+	unite(new_binomial_heap);
+}
+
+template <class T, template <class> class Allocator> BinomialHeapNode<T> *BinomialHeap<T, Allocator>::getParent(BinomialHeapNode<T> *node)
+{
+	// Walks left over the siblings of higher degree. The node moves up to a
+	// position of higher degree on every step of a decreaseKey, so the walks
+	// of the whole decreaseKey add up to O(log n).
+	while (node->parent != NULL && node->parent->leftmostChild != node)
+		node = node->parent;
+	return node->parent;
+}
+
+template <class T, template <class> class Allocator> void BinomialHeap<T, Allocator>::swapWithParent(BinomialHeapNode<T> *node, BinomialHeapNode<T> *parent)
+{
+	// The parent takes the place (and the children) of the node among its
+	// siblings, and the node takes the place of the parent, so every position
+	// keeps its degree. Only the links at the two places change.
+	BinomialHeapNode<T> *left = node->parent, *up = parent->parent, *right = parent->right, *children = node->leftmostChild;
+	if (left == parent)
+	{
+		node->leftmostChild = parent;
+		parent->parent = node;
+	}
+	else
+	{
+		node->leftmostChild = parent->leftmostChild;
+		node->leftmostChild->parent = node;
+		left->right = parent;
+		parent->parent = left;
+	}
+	parent->right = node->right;
+	if (parent->right != NULL)
+		parent->right->parent = parent;
+	parent->leftmostChild = children;
+	if (children != NULL)
+		children->parent = parent;
+	// A root has no link on its left, so it is found in the root list.
+	if (up == NULL)
+	{
+		if (root == parent)
+			root = node;
+		else
+		{
+			for (left = root; left->right != parent; left = left->right)
+				;
+			left->right = node;
+		}
+	}
+	else if (up->leftmostChild == parent)
+		up->leftmostChild = node;
+	else
+		up->right = node;
+	node->parent = up;
+	node->right = right;
+	if (up != NULL && right != NULL)
+		right->parent = node;
+}
+
+template <class T, template <class> class Allocator> void BinomialHeap<T, Allocator>::decreaseKey(BinomialHeapNode<T> *ptr, const T &newKey)
+{
+	if (ptr->key > newKey)
+	{
+		ptr->key = newKey;
+		siftUp(ptr);
+	}
+}
+
+template <class T, template <class> class Allocator> template <class Priority>
+void BinomialHeap<T, Allocator>::decreasePriority(BinomialHeapNode<T> *ptr, const Priority &newPriority)
+{
+	if (newPriority < ptr->key.priority)
+	{
+		ptr->key.priority = newPriority;
+		siftUp(ptr);
+	}
+}
+
+template <class T, template <class> class Allocator> void BinomialHeap<T, Allocator>::siftUp(BinomialHeapNode<T> *node)
+{
+	BinomialHeapNode<T> *parent;
+	while ((parent = getParent(node)) != NULL && node->key < parent->key)
+		swapWithParent(node, parent);
+	if (node->parent == NULL && min_element->key > node->key)
+		min_element = node;
+}
+
+#endif // #ifndef __BINOMIAL_HEAP_H__
@@ -0,0 +1,98 @@
+#include <cstdlib>
+#include <cstdio>
+#include <ctime>
+#include <vector>
+#include "DaryHeap.h"
+using namespace std;
+
+const int NUM_VERTICES = 1 << 18;
+const int NUM_EDGES = 1 << 21;
+
+int edge_to[NUM_EDGES], edge_weight[NUM_EDGES];
+int first_edge[NUM_VERTICES + 1];
+
+// Dijkstra from vertex 0 over the random graph built in main.
+template <int D> void benchmark()
+{
+	DaryHeap<pair<int, int>, D> heap;
+	vector<int> distance(NUM_VERTICES, -1), handle(NUM_VERTICES, -1);
+	vector<bool> done(NUM_VERTICES, false);
+	long long checksum = 0;
+	unsigned startTime = clock();
+	int u, v, e;
+	distance[0] = 0;
+	handle[0] = heap.insert(make_pair(0, 0));
+	while (heap.getSize() > 0)
+	{
+		u = heap.extractMin().second;
+		done[u] = true;
+		checksum += distance[u];
+		for (e = first_edge[u]; e < first_edge[u + 1]; e++)
+		{
+			v = edge_to[e];
+			if (done[v])
+				continue;
+			if (distance[v] == -1)
+			{
+				distance[v] = distance[u] + edge_weight[e];
+				handle[v] = heap.insert(make_pair(distance[v], v));
+			}
+			else if (distance[v] > distance[u] + edge_weight[e])
+			{
+				distance[v] = distance[u] + edge_weight[e];
+				heap.decreaseKey(handle[v], make_pair(distance[v], v));
+			}
+		}
+	}
+	fprintf(stdout, "%d-ary heap: %.3lfs, checksum %lld\n", D,
+		(double)(clock() - startTime) / (double)CLOCKS_PER_SEC, checksum);
+}
+
+// Merges with an empty heap on either side (or both) and checks the keys
+// come out in order and the handles of the merged heap still work.
+bool checkMerge()
+{
+	DaryHeap<int> empty, other_empty, heap, added;
+	int i, handle, offset, previous = -1;
+	bool correct = true;
+	empty.merge(other_empty);
+	correct = correct && empty.getSize() == 0 && other_empty.getSize() == 0;
+	for (i = 0; i < 100; i++)
+		added.insert(rand() % 1000);
+	handle = added.insert(1000);
+	offset = heap.merge(added);
+	heap.merge(empty);
+	correct = correct && heap.getSize() == 101 && added.getSize() == 0;
+	heap.decreaseKey(handle + offset, -1);
+	correct = correct && heap.getMin() == -1;
+	heap.extractMin();
+	while (heap.getSize() > 0)
+	{
+		i = heap.extractMin();
+		if (i < previous)
+			correct = false;
+		previous = i;
+	}
+	return correct;
+}
+
+int main()
+{
+	int i;
+	srand(42);
+	// Random graph in adjacency-array form: edges are grouped by source.
+	for (i = 0; i < NUM_EDGES; i++)
+		first_edge[rand() % NUM_VERTICES + 1]++;
+	for (i = 0; i < NUM_VERTICES; i++)
+		first_edge[i + 1] += first_edge[i];
+	for (i = 0; i < NUM_EDGES; i++)
+	{
+		edge_to[i] = rand() % NUM_VERTICES;
+		edge_weight[i] = rand() % 1000 + 1;
+	}
+	benchmark<2>();
+	benchmark<4>();
+	benchmark<8>();
+	fprintf(stdout, "merge with empty heaps: %s\n", checkMerge() ? "correct" : "INCORRECT");
+	return 0;
+}
@@ -0,0 +1,169 @@
+#ifndef __DARY_HEAP_H__
+#define __DARY_HEAP_H__
+
+#include <vector>
+
+/**
+* Array-backed d-ary min-heap with the same interface as FibonacciHeap.
+*
+* Keys live in one contiguous array (children of slot i are D * i + 1 ...
+* D * i + D), so sifting touches a few cache lines instead of chasing
+* pointers. insert returns an integer handle that stays valid until the
+* element is extracted; the side table position maps handles to slots.
+*/
+template <class T, int D = 4> class DaryHeap
+{
+public:
+	DaryHeap();
+	int insert(const T &);
+	T getMin() const;
+	T extractMin();
+	// Returns the offset to add to the handles issued by the merged heap.
+	int merge(DaryHeap<T, D> &);
+	void decreaseKey(int, const T &);
+	int getSize() const;
+
+private:
+	// Heap-ordered keys and the handle owning each slot.
+	std::vector<T> keys;
+	std::vector<int> handles;
+	// position[handle] is the slot of the element, or -1 once extracted.
+	std::vector<int> position;
+	std::vector<int> free_handles;
+	void sift_up(int);
+	void sift_down(int);
+	void place(int, const T &, int);
+};
+
+template <class T, int D> DaryHeap<T, D>::DaryHeap()
+{
+}
+
+template <class T, int D> void DaryHeap<T, D>::place(int slot, const T &key, int handle)
+{
+	keys[slot] = key;
+	handles[slot] = handle;
+	position[handle] = slot;
+}
+
+template <class T, int D> int DaryHeap<T, D>::insert(const T &key)
+{
+	int handle;
+	if (free_handles.empty())
+	{
+		handle = position.size();
+		position.push_back(-1);
+	}
+	else
+	{
+		handle = free_handles.back();
+		free_handles.pop_back();
+	}
+	keys.push_back(key);
+	handles.push_back(handle);
+	position[handle] = keys.size() - 1;
+	sift_up(keys.size() - 1);
+	return handle;
+}
+
+template <class T, int D> T DaryHeap<T, D>::getMin() const
+{
+	return keys[0];
+}
+
+template <class T, int D> T DaryHeap<T, D>::extractMin()
+{
+	T result = keys[0];
+	int last = keys.size() - 1;
+	position[handles[0]] = -1;
+	free_handles.push_back(handles[0]);
+	if (last > 0)
+		place(0, keys[last], handles[last]);
+	keys.pop_back();
+	handles.pop_back();
+	if (last > 0)
+		sift_down(0);
+	return result;
+}
+
+template <class T, int D> int DaryHeap<T, D>::merge(DaryHeap<T, D> &dh)
+{
+	int offset = position.size(), n = keys.size(), m = dh.keys.size(), i, log_size = 0;
+	for (i = 0; i < (int)dh.position.size(); i++)
+		position.push_back(dh.position[i] == -1 ? -1 : dh.position[i] + n);
+	for (i = 0; i < (int)dh.free_handles.size(); i++)
+		free_handles.push_back(dh.free_handles[i] + offset);
+	keys.insert(keys.end(), dh.keys.begin(), dh.keys.end());
+	for (i = 0; i < m; i++)
+		handles.push_back(dh.handles[i] + offset);
+	for (i = n + m; i > 1; i /= D)
+		log_size++;
+	// Sift the new elements up one by one unless rebuilding the whole array
+	// bottom-up is cheaper.
+	if ((long long)m * log_size < n + m)
+		for (i = n; i < n + m; i++)
+			sift_up(i);
+	else
+		// The last parent; none when there are fewer than two elements.
+		for (i = n + m <= 1 ? -1 : (n + m - 2) / D; i >= 0; i--)
+			sift_down(i);
+	dh.keys.clear();
+	dh.handles.clear();
+	dh.position.clear();
+	dh.free_handles.clear();
+	return offset;
+}
+
+template <class T, int D> void DaryHeap<T, D>::decreaseKey(int handle, const T &new_key)
+{
+	int slot = position[handle];
+	if (keys[slot] > new_key)
+	{
+		keys[slot] = new_key;
+		sift_up(slot);
+	}
+}
+
+template <class T, int D> int DaryHeap<T, D>::getSize() const
+{
+	return keys.size();
+}
+
+template <class T, int D> void DaryHeap<T, D>::sift_up(int slot)
+{
+	T key = keys[slot];
+	int handle = handles[slot], parent;
+	while (slot > 0)
+	{
+		parent = (slot - 1) / D;
+		if (!(keys[parent] > key))
+			break;
+		place(slot, keys[parent], handles[parent]);
+		slot = parent;
+	}
+	place(slot, key, handle);
+}
+
+template <class T, int D> void DaryHeap<T, D>::sift_down(int slot)
+{
+	T key = keys[slot];
+	int handle = handles[slot], size = keys.size(), first, last, best, i;
+	while (1)
+	{
+		first = slot * D + 1;
+		if (first >= size)
+			break;
+		last = first + D < size ? first + D : size;
+		best = first;
+		for (i = first + 1; i < last; i++)
+			if (keys[best] > keys[i])
+				best = i;
+		if (!(key > keys[best]))
+			break;
+		place(slot, keys[best], handles[best]);
+		slot = best;
+	}
+	place(slot, key, handle);
+}
+
+#endif // #ifndef __DARY_HEAP_H__
@@ -0,0 +1,426 @@
+/**
+* Dynamic Interval Tree implementation in C++
+* @keywords: Data Structures, Dynamic RMQ, Sparse coordinates
+*
+* The same interval update (add a value to all cells in an interval) and
+* interval query (maximum value inside an interval) as IntervalTree, over the
+* indices [0, 2^63) instead of a dense array. Every cell starts with the same
+* initial value.
+*
+* A dynamic segment tree that stores lazy adds creates about two nodes per
+* level for each border of an update, more than 200 nodes per update on 63
+* levels. Instead an update of [idx1, idx2] is stored as two point changes:
+* +add at idx1 and -add at idx2 + 1, so a cell holds the initial value plus
+* the sum of the changes up to it. The changes are the leaves of a binary
+* trie over the bits of the index whose chains of single children are
+* compressed, so an update creates at most four nodes. Every node keeps the
+* sum of the changes in its block and the maximum prefix sum over the cells
+* of the block, and a query combines O(63) of them.
+*
+* Nodes are obtained from Allocator, see NodePool.h.
+*/
+
+#ifndef __DYNAMIC_INTERVAL_TREE_H__
+#define __DYNAMIC_INTERVAL_TREE_H__
+
+#include <algorithm>
+#include <type_traits>
+#include "NodePool.h"
+using namespace std;
+
+template <typename T, template <class> class Allocator = NodePool> class DynamicIntervalTree {
+public:
+
+	// The largest index.
+	static const long long MAX_IDX = 0x7fffffffffffffffLL;
+
+	DynamicIntervalTree(const T &initial = T()) {
+		this->initial = initial;
+		root = NULL;
+		node_count = 0;
+	}
+
+	~DynamicIntervalTree() {
+		if (!Allocator<Node>::releases_in_bulk || !is_trivially_destructible<T>::value)
+			deleteSubtree(root);
+	}
+
+	/**
+	* Adds the value add to each element in the interval [idx1, idx2].
+	*/
+	void update(long long idx1, long long idx2, const T &add) {
+		root = change(root, idx1, add);
+		if (idx2 < MAX_IDX)
+			root = change(root, idx2 + 1, -add);
+	}
+
+	/**
+	* Returns the maximum value in the interval [idx1, idx2].
+	*/
+	T query(long long idx1, long long idx2) const {
+		T before = T();
+		T best = aggregate(root, 0, idx1, idx2, before).best;
+		return initial + before + best;
+	}
+
+	long long getNodeCount() const {
+		return node_count;
+	}
+
+	long long getPeakNodeMemory() const {
+		return allocator.getPeakBytes();
+	}
+
+private:
+
+	struct Node {
+		// The block of the node is [key, key + 2^level).
+		unsigned long long key;
+		int level;
+		// sum is the sum of the changes in the block, best the maximum of
+		// the sums from the start of the block to each of its cells.
+		T sum, best;
+		// The lower and the upper half of the block. A child may cover a
+		// smaller block inside its half; the cells outside have no changes.
+		Node *child[2];
+
+		Node(unsigned long long key, int level) : key(key), level(level), sum(), best() {
+			child[0] = NULL;
+			child[1] = NULL;
+		}
+	};
+
+	// The sum and the best prefix sum of a run of cells.
+	struct Aggregate {
+		T sum, best;
+	};
+
+	DynamicIntervalTree(const DynamicIntervalTree &);
+	DynamicIntervalTree &operator=(const DynamicIntervalTree &);
+
+	static unsigned long long last(const Node *node) {
+		return node->key + ((1ULL << node->level) - 1);
+	}
+
+	// The number of bits of x, which is not 0.
+	static int bitLength(unsigned long long x) {
+#ifdef __GNUC__
+		return 64 - __builtin_clzll(x);
+#else
+		int result = 0;
+		while (x != 0) {
+			x >>= 1;
+			result++;
+		}
+		return result;
+#endif
+	}
+
+	// Appends the cells of next after those of prefix.
+	static Aggregate combine(const Aggregate &prefix, const Aggregate &next) {
+		Aggregate result = { prefix.sum + next.sum, max(prefix.best, prefix.sum + next.best) };
+		return result;
+	}
+
+	// Aggregate of a half of the block of a node. Cells before the block of
+	// child have no changes, so their prefix sum is zero.
+	static Aggregate half(const Node *child, unsigned long long begin) {
+		Aggregate result = { T(), T() };
+		if (child != NULL) {
+			result.sum = child->sum;
+			result.best = child->key > begin ? max(T(), child->best) : child->best;
+		}
+		return result;
+	}
+
+	void pull(Node *node) {
+		unsigned long long middle = node->key + (1ULL << (node->level - 1));
+		Aggregate result = combine(half(node->child[0], node->key), half(node->child[1], middle));
+		node->sum = result.sum;
+		node->best = result.best;
+	}
+
+	Node *createLeaf(unsigned long long idx, const T &add) {
+		Node *node = allocator.allocate(idx, 0);
+		node->sum = add;
+		node->best = add;
+		node_count++;
+		return node;
+	}
+
+	// Adds add to the change at idx in the subtree of node, and returns the
+	// new root of the subtree.
+	Node *change(Node *node, unsigned long long idx, const T &add) {
+		Node *branch;
+		int level, side;
+		if (node == NULL)
+			return createLeaf(idx, add);
+		if (idx < node->key || idx > last(node)) {
+			// idx is outside the block: a new node for the smallest block
+			// holding both becomes the parent of node and of a new leaf.
+			level = bitLength(idx ^ node->key);
+			branch = allocator.allocate(idx >> level << level, level);
+			node_count++;
+			side = (idx >> (level - 1)) & 1;
+			branch->child[side] = createLeaf(idx, add);
+			branch->child[side ^ 1] = node;
+			pull(branch);
+			return branch;
+		}
+		if (node->level == 0) {
+			node->sum += add;
+			node->best = node->sum;
+			return node;
+		}
+		side = (idx >> (node->level - 1)) & 1;
+		node->child[side] = change(node->child[side], idx, add);
+		pull(node);
+		return node;
+	}
+
+	// Aggregate of the cells from max(begin, idx1) to the end of the block of
+	// node or idx2, whichever comes first, where node is the only content of
+	// a half block starting at begin. The cells after the block of node
+	// never change the maximum, so the end of the half is not needed. Adds
+	// the changes of the subtree before idx1 to before.
+	static Aggregate aggregate(const Node *node, unsigned long long begin,
+		unsigned long long idx1, unsigned long long idx2, T &before) {
+		Aggregate result = { T(), T() }, part;
+		unsigned long long middle;
+		bool found = false;
+		if (node == NULL)
+			return result;
+		if (last(node) < idx1) {
+			before += node->sum;
+			return result;
+		}
+		// The cells before the block of the node.
+		if (node->key > max(begin, idx1)) {
+			if (idx2 < node->key)
+				return result;
+			found = true;
+		}
+		if (idx1 <= node->key && last(node) <= idx2) {
+			part.sum = node->sum;
+			part.best = node->best;
+			result = found ? combine(result, part) : part;
+			found = true;
+		} else if (idx2 >= node->key) {
+			middle = node->key + (1ULL << (node->level - 1));
+			if (idx1 < middle) {
+				part = aggregate(node->child[0], node->key, idx1, idx2, before);
+				result = found ? combine(result, part) : part;
+				found = true;
+			} else if (node->child[0] != NULL)
+				before += node->child[0]->sum;
+			if (idx2 >= middle) {
+				part = aggregate(node->child[1], middle, idx1, idx2, before);
+				result = found ? combine(result, part) : part;
+				found = true;
+			}
+		}
+		// The cells after the block add nothing: their prefix sum is that of
+		// the last cell of the block, which best already includes.
+		return result;
+	}
+
+	void deleteSubtree(Node *node) {
+		if (node == NULL)
+			return;
+		deleteSubtree(node->child[0]);
+		deleteSubtree(node->child[1]);
+		allocator.deallocate(node);
+	}
+
+	Node *root;
+	T initial;
+	long long node_count;
+	Allocator<Node> allocator;
+};
+
+#endif // #ifndef __DYNAMIC_INTERVAL_TREE_H__
+
+
+#include <cstdio>
+#include <chrono>
+#include <vector>
+
+const int NUM_UPDATES = 1 << 20;
+const int NUM_QUERIES = 1 << 20;
+// The reference tree needs far more memory, so it gets fewer updates.
+const int NUM_REFERENCE_UPDATES = 1 << 16;
+
+// A dynamic segment tree with lazy adds, creating every node an update
+// touches. Only used to compare the number of nodes per update.
+template <typename T> class LazyDynamicIntervalTree {
+public:
+
+	LazyDynamicIntervalTree() {
+		root = NULL;
+		node_count = 0;
+	}
+
+	void update(long long idx1, long long idx2, const T &add) {
+		root = update(root, 0, DynamicIntervalTree<T>::MAX_IDX, idx1, idx2, add);
+	}
+
+	T query(long long idx1, long long idx2) const {
+		return query(root, 0, DynamicIntervalTree<T>::MAX_IDX, idx1, idx2);
+	}
+
+	long long getNodeCount() const {
+		return node_count;
+	}
+
+	long long getPeakNodeMemory() const {
+		return allocator.getPeakBytes();
+	}
+
+private:
+
+	struct Node {
+		T value, lazy;
+		Node *left, *right;
+
+		Node() : value(), lazy(), left(NULL), right(NULL) {
+		}
+	};
+
+	Node *update(Node *node, long long begin, long long end, long long idx1, long long idx2, const T &add) {
+		long long mid;
+		if (node == NULL) {
+			node = allocator.allocate();
+			node_count++;
+		}
+		if (idx1 <= begin && end <= idx2) {
+			node->value += add;
+			node->lazy += add;
+			return node;
+		}
+		mid = begin + ((end - begin) >> 1);
+		if (idx1 <= mid)
+			node->left = update(node->left, begin, mid, idx1, idx2, add);
+		if (idx2 > mid)
+			node->right = update(node->right, mid + 1, end, idx1, idx2, add);
+		node->value = max(node->left != NULL ? node->left->value : T(),
+			node->right != NULL ? node->right->value : T()) + node->lazy;
+		return node;
+	}
+
+	// A missing node stands for a block that no update has touched.
+	T query(const Node *node, long long begin, long long end, long long idx1, long long idx2) const {
+		long long mid;
+		if (node == NULL)
+			return T();
+		if (idx1 <= begin && end <= idx2)
+			return node->value;
+		mid = begin + ((end - begin) >> 1);
+		if (idx2 <= mid)
+			return query(node->left, begin, mid, idx1, idx2) + node->lazy;
+		if (idx1 > mid)
+			return query(node->right, mid + 1, end, idx1, idx2) + node->lazy;
+		return max(query(node->left, begin, mid, idx1, idx2),
+			query(node->right, mid + 1, end, idx1, idx2)) + node->lazy;
+	}
+
+	Node *root;
+	long long node_count;
+	NodePool<Node> allocator;
+};
+
+unsigned long long state = 42;
+
+const int NUM_CHECK_QUERIES = 1 << 16;
+
+// A random index in [0, 2^63).
+long long randomIndex() {
+	state ^= state << 13;
+	state ^= state >> 7;
+	state ^= state << 17;
+	return (long long)(state >> 1);
+}
+
+void randomInterval(long long &idx1, long long &idx2) {
+	idx1 = randomIndex();
+	idx2 = randomIndex();
+	if (idx1 > idx2)
+		swap(idx1, idx2);
+}
+
+// A random interval inside [0, range), or reaching the last index now and
+// then. range 0 stands for all indices.
+void randomCheckInterval(long long range, long long &idx1, long long &idx2) {
+	randomInterval(idx1, idx2);
+	if (range != 0) {
+		idx1 %= range;
+		idx2 %= range;
+		if (idx1 > idx2)
+			swap(idx1, idx2);
+	}
+	if (state % 16 == 0)
+		idx2 = DynamicIntervalTree<long long>::MAX_IDX;
+}
+
+// Applies the same updates to a tree and to the lazy reference, and compares
+// their answers to random queries.
+bool check(long long range) {
+	DynamicIntervalTree<long long> tree;
+	LazyDynamicIntervalTree<long long> reference;
+	long long idx1, idx2, add;
+	int i;
+	bool correct = true;
+	for (i = 0; i < NUM_REFERENCE_UPDATES; i++) {
+		randomCheckInterval(range, idx1, idx2);
+		// Mostly negative, so that the maximum is often in cells without
+		// changes.
+		add = (long long)(state % 2001) - 1500;
+		tree.update(idx1, idx2, add);
+		reference.update(idx1, idx2, add);
+	}
+	for (i = 0; i < NUM_CHECK_QUERIES; i++) {
+		randomCheckInterval(range, idx1, idx2);
+		if (tree.query(idx1, idx2) != reference.query(idx1, idx2))
+			correct = false;
+	}
+	return correct;
+}
+
+int main(void) {
+	DynamicIntervalTree<long long> tree;
+	LazyDynamicIntervalTree<long long> reference;
+	long long idx1, idx2, checksum = 0;
+	int i;
+
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for (i = 0; i < NUM_UPDATES; i++) {
+		randomInterval(idx1, idx2);
+		tree.update(idx1, idx2, (long long)(state % 2001) - 1000);
+	}
+	double update_elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	start = chrono::steady_clock::now();
+	for (i = 0; i < NUM_QUERIES; i++) {
+		randomInterval(idx1, idx2);
+		checksum += tree.query(idx1, idx2);
+	}
+	double query_elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	fprintf(stdout, "%d updates: %.3lfs (%.2lf Mops/s), %d queries: %.3lfs (%.2lf Mops/s), checksum %lld\n",
+		NUM_UPDATES, update_elapsed, NUM_UPDATES / update_elapsed / 1e6,
+		NUM_QUERIES, query_elapsed, NUM_QUERIES / query_elapsed / 1e6, checksum);
+	fprintf(stdout, "%lld nodes (%.2lf per update), %.1lf MB of nodes\n", tree.getNodeCount(),
+		(double)tree.getNodeCount() / NUM_UPDATES, tree.getPeakNodeMemory() / 1048576.0);
+
+	start = chrono::steady_clock::now();
+	for (i = 0; i < NUM_REFERENCE_UPDATES; i++) {
+		randomInterval(idx1, idx2);
+		reference.update(idx1, idx2, (long long)(state % 2001) - 1000);
+	}
+	double reference_elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	fprintf(stdout, "Lazy dynamic segment tree, %d updates: %.3lfs (%.2lf Mops/s), %lld nodes (%.2lf per update), %.1lf MB of nodes\n",
+		NUM_REFERENCE_UPDATES, reference_elapsed, NUM_REFERENCE_UPDATES / reference_elapsed / 1e6,
+		reference.getNodeCount(), (double)reference.getNodeCount() / NUM_REFERENCE_UPDATES,
+		reference.getPeakNodeMemory() / 1048576.0);
+	bool sparse = check(0), dense = check(1000);
+	fprintf(stdout, "Sparse indices: %s, dense indices: %s\n", sparse ? "correct" : "INCORRECT",
+		dense ? "correct" : "INCORRECT");
+	return 0;
+}
@@ -0,0 +1,350 @@
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <chrono>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+#include <sys/resource.h>
+#include "PairingHeap.h"
+using namespace std;
+
+/**
+* External-memory priority queue for more elements than fit in memory.
+*
+* New elements go to an insertion heap (a PairingHeap). When it holds as many
+* elements as the memory budget allows, its elements are sorted and written
+* as a run to a temporary file. Each run is read back through a buffer of one
+* block, and the runs are kept in a binary heap ordered by their first unread
+* element, so extractMin compares the insertion heap with a single run.
+*
+* Half of the budget goes to the insertion heap and half to the run buffers.
+* As in a sequence heap, runs are grouped in levels: a spilled run is on level
+* 0, and when a level has merge_factor runs they are merged into one run on
+* the next level. Every element is thus rewritten O(log_k(N / M)) times, where
+* k is the merge factor and N / M the number of spills.
+*
+* T is written to the files as raw bytes, so it must be trivially copyable.
+*/
+template <class T> class ExternalHeap
+{
+	static_assert(std::is_trivially_copyable<T>::value,
+		"ExternalHeap can only store trivially copyable types.");
+
+public:
+	ExternalHeap(long long memory_budget);
+	~ExternalHeap();
+	void push(const T &);
+	const T &getMin() const;
+	T extractMin();
+	long long getSize() const;
+	int getRunCount() const;
+	// The number of bytes written to temporary files so far.
+	long long getSpilledBytes() const;
+	// The number of bytes read from temporary files so far.
+	long long getReadBytes() const;
+
+private:
+	static const int MAX_BLOCK_BYTES = 1 << 16;
+
+	struct Run
+	{
+		FILE *file;
+		// Elements still in the file, after the buffered ones.
+		long long unread;
+		vector<T> buffer;
+		int position, level;
+	};
+
+	struct larger_head
+	{
+		bool operator()(const Run *x, const Run *y) const
+		{
+			return x->buffer[x->position] > y->buffer[y->position];
+		}
+	};
+
+	struct not_on_level
+	{
+		int level;
+
+		bool operator()(const Run *x) const
+		{
+			return x->level != level;
+		}
+	};
+
+	PairingHeap<T> insertion;
+	int insertion_capacity, block_size, max_runs, merge_factor;
+	// Binary heap of the runs, the one with the smallest head at the front.
+	vector<Run *> runs;
+	// The number of runs on each level.
+	vector<int> level_runs;
+	// Reused to write blocks to a run, and to sort the insertion heap.
+	vector<T> output, sorted;
+	long long size, spilled_bytes, read_bytes;
+	ExternalHeap(const ExternalHeap &);
+	ExternalHeap &operator=(const ExternalHeap &);
+	Run *create_run();
+	void write_block(Run *);
+	void fill_buffer(Run *);
+	void delete_run(Run *);
+	void add_run(Run *);
+	void spill();
+	void merge_level(int);
+	T extract_from(vector<Run *> &);
+	bool insertion_first() const;
+};
+
+template <class T> ExternalHeap<T>::ExternalHeap(long long memory_budget)
+{
+	long long half = memory_budget / 2;
+	insertion_capacity = max(1LL, half / (long long)sizeof(PairingHeapNode<T>));
+	// Blocks are shrunk for small budgets so that at least 16 runs fit.
+	block_size = max(1LL, min((long long)MAX_BLOCK_BYTES, half / 16) / (long long)sizeof(T));
+	max_runs = max(2LL, half / (block_size * (long long)sizeof(T)));
+	// Leaves room for the runs of a second level.
+	merge_factor = max(2, max_runs / 2);
+	size = 0;
+	spilled_bytes = 0;
+	read_bytes = 0;
+}
+
+template <class T> ExternalHeap<T>::~ExternalHeap()
+{
+	int i;
+	for (i = 0; i < (int)runs.size(); i++)
+		delete_run(runs[i]);
+}
+
+template <class T> typename ExternalHeap<T>::Run *ExternalHeap<T>::create_run()
+{
+	Run *run = new Run;
+	// tmpfile removes the file as soon as it is closed.
+	run->file = tmpfile();
+	if (run->file == NULL)
+	{
+		delete run;
+		throw runtime_error("cannot create a temporary file");
+	}
+	run->unread = 0;
+	run->position = 0;
+	return run;
+}
+
+template <class T> void ExternalHeap<T>::write_block(Run *run)
+{
+	if (fwrite(output.data(), sizeof(T), output.size(), run->file) != output.size())
+		throw runtime_error("cannot write to a temporary file");
+	run->unread += output.size();
+	spilled_bytes += output.size() * sizeof(T);
+	output.clear();
+}
+
+template <class T> void ExternalHeap<T>::fill_buffer(Run *run)
+{
+	int count = min((long long)block_size, run->unread);
+	run->buffer.resize(count);
+	if (fread(run->buffer.data(), sizeof(T), count, run->file) != (size_t)count)
+		throw runtime_error("cannot read from a temporary file");
+	run->unread -= count;
+	read_bytes += count * sizeof(T);
+	run->position = 0;
+}
+
+template <class T> void ExternalHeap<T>::delete_run(Run *run)
+{
+	fclose(run->file);
+	delete run;
+}
+
+template <class T> void ExternalHeap<T>::add_run(Run *run)
+{
+	if ((int)level_runs.size() <= run->level)
+		level_runs.resize(run->level + 1, 0);
+	level_runs[run->level]++;
+	runs.push_back(run);
+	push_heap(runs.begin(), runs.end(), larger_head());
+}
+
+// Writes the contents of the insertion heap to a new run, in order.
+template <class T> void ExternalHeap<T>::spill()
+{
+	Run *run;
+	int i, level, next;
+	// Only reached when there are too many levels for the buffers: the
+	// lowest level with more than one run is merged early.
+	for (level = 0; (int)runs.size() >= max_runs && level < (int)level_runs.size(); level++)
+		if (level_runs[level] > 1)
+			merge_level(level);
+	// Every level is down to one run: the run of the lowest level joins the
+	// next level that has one, and the two are merged.
+	while ((int)runs.size() >= max_runs)
+	{
+		for (level = 0; level_runs[level] == 0; level++)
+			;
+		for (next = level + 1; level_runs[next] == 0; next++)
+			;
+		for (i = 0; i < (int)runs.size(); i++)
+			if (runs[i]->level == level)
+				runs[i]->level = next;
+		level_runs[next] += level_runs[level];
+		level_runs[level] = 0;
+		merge_level(next);
+	}
+	run = create_run();
+	run->level = 0;
+	// Sorting is much faster than extracting the elements one by one, as it
+	// does not chase pointers through the heap.
+	insertion.extractAll(sorted);
+	sort(sorted.begin(), sorted.end());
+	for (i = 0; i < (int)sorted.size(); i += block_size)
+	{
+		output.assign(sorted.begin() + i, sorted.begin() + min(i + block_size, (int)sorted.size()));
+		write_block(run);
+	}
+	sorted.clear();
+	rewind(run->file);
+	fill_buffer(run);
+	add_run(run);
+	for (level = 0; level < (int)level_runs.size() && level_runs[level] >= merge_factor; level++)
+		merge_level(level);
+}
+
+// Replaces the runs of level by a single run on the next level.
+template <class T> void ExternalHeap<T>::merge_level(int level)
+{
+	vector<Run *> merged;
+	Run *run = create_run();
+	not_on_level other = { level };
+	typename vector<Run *>::iterator middle = partition(runs.begin(), runs.end(), other);
+	merged.assign(middle, runs.end());
+	runs.erase(middle, runs.end());
+	make_heap(runs.begin(), runs.end(), larger_head());
+	make_heap(merged.begin(), merged.end(), larger_head());
+	while (!merged.empty())
+	{
+		output.push_back(extract_from(merged));
+		if ((int)output.size() == block_size)
+			write_block(run);
+	}
+	if (!output.empty())
+		write_block(run);
+	rewind(run->file);
+	fill_buffer(run);
+	run->level = level + 1;
+	add_run(run);
+}
+
+// Extracts the smallest head of the runs in heap, a binary heap like runs.
+template <class T> T ExternalHeap<T>::extract_from(vector<Run *> &heap)
+{
+	Run *run;
+	pop_heap(heap.begin(), heap.end(), larger_head());
+	run = heap.back();
+	T result = run->buffer[run->position++];
+	if (run->position == (int)run->buffer.size())
+	{
+		if (run->unread == 0)
+		{
+			heap.pop_back();
+			level_runs[run->level]--;
+			delete_run(run);
+			return result;
+		}
+		fill_buffer(run);
+	}
+	push_heap(heap.begin(), heap.end(), larger_head());
+	return result;
+}
+
+// Whether the minimum is in the insertion heap: the head of the best run is
+// not smaller than the minimum of the insertion heap.
+template <class T> bool ExternalHeap<T>::insertion_first() const
+{
+	if (runs.empty())
+		return true;
+	return insertion.getSize() > 0 && !(runs[0]->buffer[runs[0]->position] < insertion.getMin());
+}
+
+template <class T> void ExternalHeap<T>::push(const T &value)
+{
+	if (insertion.getSize() == insertion_capacity)
+		spill();
+	insertion.insert(value);
+	size++;
+}
+
+template <class T> const T &ExternalHeap<T>::getMin() const
+{
+	if (insertion_first())
+		return insertion.getMin();
+	return runs[0]->buffer[runs[0]->position];
+}
+
+template <class T> T ExternalHeap<T>::extractMin()
+{
+	size--;
+	if (insertion_first())
+		return insertion.extractMin();
+	return extract_from(runs);
+}
+
+template <class T> long long ExternalHeap<T>::getSize() const
+{
+	return size;
+}
+
+template <class T> int ExternalHeap<T>::getRunCount() const
+{
+	return runs.size();
+}
+
+template <class T> long long ExternalHeap<T>::getSpilledBytes() const
+{
+	return spilled_bytes;
+}
+
+template <class T> long long ExternalHeap<T>::getReadBytes() const
+{
+	return read_bytes;
+}
+
+// Usage: ExternalHeap [budget_mb] [ratio] - pushes ratio times as many bytes
+// of keys as the memory budget, then extracts them all. Defaults: 16 MB, 10.
+int main(int argc, char *argv[])
+{
+	long long budget = (argc > 1 ? atoll(argv[1]) : 16) << 20, count, i;
+	int ratio = argc > 2 ? atoi(argv[2]) : 10;
+	long long key, previous = -1;
+	unsigned state = 42;
+	struct rusage usage;
+	bool sorted = true;
+	ExternalHeap<long long> heap(budget);
+	count = budget * ratio / (long long)sizeof(long long);
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for (i = 0; i < count; i++)
+	{
+		state = state * 1103515245 + 12345;
+		heap.push(((long long)state << 16) ^ i);
+	}
+	double push_elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	int runs = heap.getRunCount();
+	start = chrono::steady_clock::now();
+	for (i = 0; i < count; i++)
+	{
+		key = heap.extractMin();
+		if (key < previous)
+			sorted = false;
+		previous = key;
+	}
+	double extract_elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	getrusage(RUSAGE_SELF, &usage);
+	fprintf(stdout, "%lld keys (%lld MB) with a %lld MB budget: %d runs, %.1lf MB written, %.1lf MB read (%.2lf times the data)\n",
+		count, count * (long long)sizeof(long long) >> 20, budget >> 20, runs, heap.getSpilledBytes() / 1048576.0,
+		heap.getReadBytes() / 1048576.0, (double)(heap.getSpilledBytes() + heap.getReadBytes()) / (count * (long long)sizeof(long long)));
+	fprintf(stdout, "push %.3lfs (%.2lf Mops/s), extractMin %.3lfs (%.2lf Mops/s), %s\n", push_elapsed,
+		count / push_elapsed / 1e6, extract_elapsed, count / extract_elapsed / 1e6, sorted ? "in order" : "NOT IN ORDER");
+	fprintf(stdout, "peak resident set size: %.1lf MB\n", usage.ru_maxrss / 1024.0);
+	return 0;
+}
@@ -0,0 +1,439 @@
+#ifndef __FIBONACCI_HEAP_H__
+#define __FIBONACCI_HEAP_H__
+
+#include <cstdlib>
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "NodePool.h"
+
+template <class T> struct FibonacciHeapNode
+{
+	T key;
+	int degree;
+	FibonacciHeapNode *left_child, *left_sibling, *right_sibling, *parent;
+	bool marked;
+
+	// The key is constructed in place from args.
+	template <class... Args> explicit FibonacciHeapNode(Args&&... args)
+		: key(std::forward<Args>(args)...)
+	{
+		degree = 0;
+		left_child = NULL;
+		parent = NULL;
+		marked = false;
+	}
+};
+
+template <class T, template <class> class Allocator = NodePool> class FibonacciHeap
+{
+public:
+	FibonacciHeap();
+	~FibonacciHeap();
+	FibonacciHeapNode<T> *insert(const T &);
+	FibonacciHeapNode<T> *insert(T &&);
+	// Constructs the key in place from args.
+	template <class... Args> FibonacciHeapNode<T> *emplace(Args&&...);
+	const T &getMin() const;
+	// The key is moved out of the heap, not copied.
+	T extractMin();
+	// Appends the (at most) k smallest keys to out in increasing order and
+	// returns their number. The forest is consolidated once for the batch.
+	int extractMinBatch(int k, std::vector<T> &out);
+	void merge(FibonacciHeap<T, Allocator> &);
+	void decreaseKey(FibonacciHeapNode <T> *, const T &);
+	// For T = Prioritized<Priority, Payload>: decreases only the priority and
+	// leaves the payload where it is.
+	template <class Priority> void decreasePriority(FibonacciHeapNode<T> *, const Priority &);
+	int getSize() const;
+	long long getAllocationCount() const;
+	long long getPeakNodeMemory() const;
+
+private:
+	FibonacciHeapNode<T> *min_element;
+	int size;
+	Allocator<FibonacciHeapNode<T> > allocator;
+	FibonacciHeap(const FibonacciHeap &);
+	FibonacciHeap &operator=(const FibonacciHeap &);
+	// degree_table[d] holds the root of degree d found so far by consolidate.
+	// It is owned by the heap and only grows, so extractMin does not allocate
+	// in steady state.
+	FibonacciHeapNode<T> **degree_table;
+	int degree_table_size;
+	// Roots of the trees not yet extracted by extractMinBatch, kept as a
+	// binary heap with the smallest key at the front.
+	std::vector<FibonacciHeapNode<T> *> batch_roots;
+	struct larger_key
+	{
+		bool operator()(const FibonacciHeapNode<T> *x, const FibonacciHeapNode<T> *y) const
+		{
+			return x->key > y->key;
+		}
+	};
+	void delete_nodes();
+	void consolidate();
+	void grow_degree_table(int);
+	void link(FibonacciHeapNode<T> *, FibonacciHeapNode<T> *);
+	void cut(FibonacciHeapNode<T> *, FibonacciHeapNode<T> *);
+	void cascading_cut(FibonacciHeapNode<T> *);
+	void key_decreased(FibonacciHeapNode<T> *);
+};
+
+template <class T, template <class> class Allocator> FibonacciHeap<T, Allocator>::FibonacciHeap()
+{
+	min_element = NULL;
+	size = 0;
+	degree_table = NULL;
+	degree_table_size = 0;
+}
+
+template <class T, template <class> class Allocator> FibonacciHeap<T, Allocator>::~FibonacciHeap()
+{
+	if (!Allocator<FibonacciHeapNode<T> >::releases_in_bulk || !std::is_trivially_destructible<T>::value)
+		delete_nodes();
+	delete[] degree_table;
+}
+
+template <class T, template <class> class Allocator> void FibonacciHeap<T, Allocator>::delete_nodes()
+{
+	FibonacciHeapNode<T> *current, *next;
+	if (min_element == NULL)
+		return;
+	// Children are spliced into the list right after their parent, so the
+	// whole forest is freed in one pass over a single linear list.
+	min_element->left_sibling->right_sibling = NULL;
+	current = min_element;
+	while (current != NULL)
+	{
+		if (current->left_child != NULL)
+		{
+			current->left_child->left_sibling->right_sibling = current->right_sibling;
+			next = current->left_child;
+		}
+		else
+			next = current->right_sibling;
+		allocator.deallocate(current);
+		current = next;
+	}
+	min_element = NULL;
+	size = 0;
+}
+
+template <class T, template <class> class Allocator> FibonacciHeapNode<T> *FibonacciHeap<T, Allocator>::insert(const T &key)
+{
+	return emplace(key);
+}
+
+template <class T, template <class> class Allocator> FibonacciHeapNode<T> *FibonacciHeap<T, Allocator>::insert(T &&key)
+{
+	return emplace(std::move(key));
+}
+
+template <class T, template <class> class Allocator> template <class... Args>
+FibonacciHeapNode<T> *FibonacciHeap<T, Allocator>::emplace(Args&&... args)
+{
+	FibonacciHeapNode<T> *new_node = allocator.allocate(std::forward<Args>(args)...);
+	if (min_element == NULL)
+	{
+		min_element = new_node;
+		min_element->left_sibling = min_element;
+		min_element->right_sibling = min_element;
+	}
+	else
+	{
+		new_node->left_sibling = min_element->left_sibling;
+		new_node->right_sibling = min_element;
+		min_element->left_sibling = new_node;
+		new_node->left_sibling->right_sibling = new_node;
+		if (min_element->key > new_node->key)
+			min_element = new_node;
+	}
+	size++;
+	return new_node;
+}
+
+template <class T, template <class> class Allocator> const T &FibonacciHeap<T, Allocator>::getMin() const
+{
+	return min_element->key;
+}
+
+template <class T, template <class> class Allocator> T FibonacciHeap<T, Allocator>::extractMin()
+{
+	T result = std::move(min_element->key);
+	FibonacciHeapNode<T> *current, *child, *next;
+	if (size == 1)
+	{
+		allocator.deallocate(min_element);
+		min_element = NULL;
+	}
+	else
+	{
+		child = min_element->left_child;
+		if (child != NULL)
+		{
+			current = child;
+			do
+			{
+				current->parent = NULL;
+				current = current->right_sibling;
+			} while (current != child);
+			// Splice the whole child list into the root list after min_element.
+			next = min_element->right_sibling;
+			current = child->left_sibling;
+			min_element->right_sibling = child;
+			child->left_sibling = min_element;
+			current->right_sibling = next;
+			next->left_sibling = current;
+		}
+		current = min_element;
+		min_element->left_sibling->right_sibling = min_element->right_sibling;
+		min_element->right_sibling->left_sibling = min_element->left_sibling;
+		min_element = min_element->right_sibling;
+		allocator.deallocate(current);
+		consolidate();
+	}
+	size--;
+	return result;
+}
+
+template <class T, template <class> class Allocator> int FibonacciHeap<T, Allocator>::extractMinBatch(int k, std::vector<T> &out)
+{
+	FibonacciHeapNode<T> *current, *child;
+	int i;
+	if (k > size)
+		k = size;
+	if (k <= 0)
+		return 0;
+	// Every extracted node is the smallest of the current roots; its children
+	// become roots in turn. The root list is only rebuilt after the batch.
+	batch_roots.clear();
+	current = min_element;
+	do
+	{
+		batch_roots.push_back(current);
+		current = current->right_sibling;
+	} while (current != min_element);
+	std::make_heap(batch_roots.begin(), batch_roots.end(), larger_key());
+	for (i = 0; i < k; i++)
+	{
+		std::pop_heap(batch_roots.begin(), batch_roots.end(), larger_key());
+		current = batch_roots.back();
+		batch_roots.pop_back();
+		out.push_back(std::move(current->key));
+		child = current->left_child;
+		if (child != NULL)
+			do
+			{
+				child->parent = NULL;
+				child->marked = false;
+				batch_roots.push_back(child);
+				std::push_heap(batch_roots.begin(), batch_roots.end(), larger_key());
+				child = child->right_sibling;
+			} while (child != current->left_child);
+		allocator.deallocate(current);
+	}
+	size -= k;
+	if (size == 0)
+	{
+		min_element = NULL;
+		return k;
+	}
+	// Links the remaining roots into a circular list and consolidates it.
+	for (i = 0; i < (int)batch_roots.size(); i++)
+	{
+		batch_roots[i]->right_sibling = batch_roots[(i + 1) % batch_roots.size()];
+		batch_roots[i]->right_sibling->left_sibling = batch_roots[i];
+	}
+	min_element = batch_roots[0];
+	consolidate();
+	return k;
+}
+
+template <class T, template <class> class Allocator> void FibonacciHeap<T, Allocator>::merge(FibonacciHeap<T, Allocator> &fh)
+{
+	FibonacciHeapNode<T> *temp, *fh_temp;
+	if (min_element == NULL)
+		min_element = fh.min_element;
+	else if (fh.min_element != NULL)
+	{
+		temp = min_element->right_sibling;
+		fh_temp = fh.min_element->right_sibling;
+		min_element->right_sibling = fh_temp;
+		fh.min_element->right_sibling = temp;
+		temp->left_sibling = fh.min_element;
+		fh_temp->left_sibling = min_element;
+		if (min_element->key > fh.min_element->key)
+			min_element = fh.min_element;
+	}
+	size += fh.size;
+	allocator.adopt(fh.allocator);
+	fh.min_element = NULL;
+	fh.size = 0;
+}
+
+template <class T, template <class> class Allocator> void FibonacciHeap<T, Allocator>::grow_degree_table(int degree)
+{
+	int new_size = degree_table_size < 16 ? 16 : degree_table_size, i;
+	FibonacciHeapNode<T> **new_table;
+	while (new_size <= degree)
+		new_size <<= 1;
+	new_table = new FibonacciHeapNode<T> *[new_size];
+	for (i = 0; i < degree_table_size; i++)
+		new_table[i] = degree_table[i];
+	for (; i < new_size; i++)
+		new_table[i] = NULL;
+	delete[] degree_table;
+	degree_table = new_table;
+	degree_table_size = new_size;
+}
+
+template <class T, template <class> class Allocator> void FibonacciHeap<T, Allocator>::consolidate()
+{
+	int max_degree = -1, degree;
+	FibonacciHeapNode<T> *current = min_element, *last = min_element->left_sibling, *next, *x, *y;
+	bool done = false;
+	// The roots that survive linking stay where they are in the root list,
+	// so only the nodes that become children are unlinked from it.
+	while (!done)
+	{
+		done = current == last;
+		next = current->right_sibling;
+		x = current;
+		while (1)
+		{
+			degree = x->degree;
+			if (degree >= degree_table_size)
+				grow_degree_table(degree);
+			y = degree_table[degree];
+			if (y == NULL)
+				break;
+			degree_table[degree] = NULL;
+			if (x->key > y->key)
+			{
+				FibonacciHeapNode<T> *temp = x;
+				x = y;
+				y = temp;
+			}
+			link(y, x);
+		}
+		degree_table[degree] = x;
+		if (max_degree < degree)
+			max_degree = degree;
+		current = next;
+	}
+	min_element = NULL;
+	for (degree = 0; degree <= max_degree; degree++)
+		if (degree_table[degree] != NULL)
+		{
+			if (min_element == NULL || min_element->key > degree_table[degree]->key)
+				min_element = degree_table[degree];
+			degree_table[degree] = NULL;
+		}
+}
+
+template <class T, template <class> class Allocator> void FibonacciHeap<T, Allocator>::link(FibonacciHeapNode<T> *y, FibonacciHeapNode<T> *x)
+{
+	y->left_sibling->right_sibling = y->right_sibling;
+	y->right_sibling->left_sibling = y->left_sibling;
+	y->parent = x;
+	if (x->left_child == NULL)
+	{
+		y->left_sibling = y;
+		y->right_sibling = y;
+	}
+	else
+	{
+		y->left_sibling = x->left_child->left_sibling;
+		y->right_sibling = x->left_child;
+		y->right_sibling->left_sibling = y;
+		y->left_sibling->right_sibling = y;
+	}
+	x->left_child = y;
+	x->degree++;
+	y->marked = false;
+}
+
+template <class T, template <class> class Allocator> void FibonacciHeap<T, Allocator>::decreaseKey(FibonacciHeapNode<T> *element, const T &new_key)
+{
+	if (element->key > new_key)
+	{
+		element->key = new_key;
+		key_decreased(element);
+	}
+}
+
+template <class T, template <class> class Allocator> template <class Priority>
+void FibonacciHeap<T, Allocator>::decreasePriority(FibonacciHeapNode<T> *element, const Priority &new_priority)
+{
+	if (new_priority < element->key.priority)
+	{
+		element->key.priority = new_priority;
+		key_decreased(element);
+	}
+}
+
+template <class T, template <class> class Allocator> void FibonacciHeap<T, Allocator>::key_decreased(FibonacciHeapNode<T> *element)
+{
+	FibonacciHeapNode<T> *y = element->parent;
+	if (y != NULL && element->key < y->key)
+	{
+		cut(element, y);
+		cascading_cut(y);
+	}
+	if (min_element->key > element->key)
+		min_element = element;
+}
+
+template <class T, template <class> class Allocator> void FibonacciHeap<T, Allocator>::cut(FibonacciHeapNode<T> *x, FibonacciHeapNode<T> *y)
+{
+	if (x->right_sibling == x)
+		y->left_child = NULL;
+	else
+	{
+		if (y->left_child == x)
+			y->left_child = x->right_sibling;
+		x->left_sibling->right_sibling = x->right_sibling;
+		x->right_sibling->left_sibling = x->left_sibling;
+
+	}
+	y->degree--;
+	x->left_sibling = min_element->left_sibling;
+	x->right_sibling = min_element;
+	min_element->left_sibling = x;
+	x->left_sibling->right_sibling = x;
+	x->parent = NULL;
+	x->marked = false;
+}
+
+template <class T, template <class> class Allocator> void FibonacciHeap<T, Allocator>::cascading_cut(FibonacciHeapNode<T> *y)
+{
+	FibonacciHeapNode<T> *z = y->parent;
+	if (z != NULL)
+	{
+		if (y->marked)
+		{
+			cut(y, z);
+			cascading_cut(z);
+		}
+		else
+			y->marked = true;
+	}
+}
+
+template <class T, template <class> class Allocator> int FibonacciHeap<T, Allocator>::getSize() const
+{
+	return size;
+}
+
+template <class T, template <class> class Allocator> long long FibonacciHeap<T, Allocator>::getAllocationCount() const
+{
+	return allocator.getAllocationCount();
+}
+
+template <class T, template <class> class Allocator> long long FibonacciHeap<T, Allocator>::getPeakNodeMemory() const
+{
+	return allocator.getPeakBytes();
+}
+
+#endif // #ifndef __FIBONACCI_HEAP_H__
@@ -0,0 +1,427 @@
+/**
+* Graph workload benchmark for the mergeable heaps.
+*
+* Runs Dijkstra's shortest paths and Prim's minimum spanning tree with
+* BinomialHeap, FibonacciHeap, PairingHeap, SkewHeap and a 4-ary DaryHeap on
+* a graph read from a DIMACS shortest-path file ("p sp n m" header, "a u v w"
+* arcs, 1-based).
+* Heaps with usable handles run decreaseKey; the others use lazy deletion,
+* pushing a new entry per improvement and skipping stale ones on extraction.
+* Dijkstra also runs with RadixHeap, which needs monotone keys and so cannot
+* be used for Prim.
+*
+* Usage:
+*	GraphBenchmark graph.gr [source]     - benchmark on a DIMACS graph
+*	GraphBenchmark --random n m out.gr   - write a random connected graph
+*	GraphBenchmark --grid rows cols out.gr - write a grid graph
+*
+* Prim treats every arc as an undirected edge, so the input should contain
+* both directions of each edge (as the DIMACS road graphs and the generated
+* graphs do).
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
+#include <utility>
+#include <vector>
+#include <sys/resource.h>
+#include "BinomialHeap.h"
+#include "DaryHeap.h"
+#include "FibonacciHeap.h"
+#include "PairingHeap.h"
+#include "RadixHeap.h"
+#include "SkewHeap.h"
+using namespace std;
+
+typedef pair<long long, int> Entry;
+
+struct Graph
+{
+	int vertices;
+	// Arcs grouped by source: the arcs of u are first_arc[u] .. first_arc[u + 1] - 1.
+	vector<int> first_arc, arc_to, arc_weight;
+};
+
+// Prints what is wrong with the input and returns false.
+bool reject(FILE *in, const char *path, int line_number, const char *reason)
+{
+	fclose(in);
+	fprintf(stderr, "%s:%d: %s\n", path, line_number, reason);
+	return false;
+}
+
+// Fails on a missing or invalid "p sp" header, and on arcs before it, with
+// an end outside [1, n] or with a negative weight.
+bool readDimacs(const char *path, Graph &graph)
+{
+	FILE *in = fopen(path, "r");
+	char line[1024];
+	int u, v, w, arcs = 0, i, line_number = 0;
+	vector<int> from, to, weight;
+	if (in == NULL)
+	{
+		fprintf(stderr, "Cannot read %s\n", path);
+		return false;
+	}
+	graph.vertices = 0;
+	while (fgets(line, sizeof(line), in) != NULL)
+	{
+		line_number++;
+		if (line[0] == 'p')
+		{
+			if (graph.vertices > 0)
+				return reject(in, path, line_number, "more than one problem line");
+			if (sscanf(line, "p sp %d %d", &graph.vertices, &arcs) != 2 || graph.vertices <= 0 || arcs < 0)
+				return reject(in, path, line_number, "expected \"p sp n m\" with n > 0 and m >= 0");
+			from.reserve(arcs);
+			to.reserve(arcs);
+			weight.reserve(arcs);
+		}
+		else if (line[0] == 'a')
+		{
+			if (graph.vertices <= 0)
+				return reject(in, path, line_number, "arc before the problem line");
+			if (sscanf(line, "a %d %d %d", &u, &v, &w) != 3)
+				return reject(in, path, line_number, "expected \"a u v w\"");
+			if (u < 1 || u > graph.vertices || v < 1 || v > graph.vertices)
+				return reject(in, path, line_number, "arc end outside [1, n]");
+			if (w < 0)
+				return reject(in, path, line_number, "negative arc weight");
+			from.push_back(u - 1);
+			to.push_back(v - 1);
+			weight.push_back(w);
+		}
+	}
+	fclose(in);
+	if (graph.vertices <= 0)
+	{
+		fprintf(stderr, "%s: no \"p sp n m\" line\n", path);
+		return false;
+	}
+	graph.first_arc.assign(graph.vertices + 1, 0);
+	graph.arc_to.resize(from.size());
+	graph.arc_weight.resize(from.size());
+	for (i = 0; i < (int)from.size(); i++)
+		graph.first_arc[from[i] + 1]++;
+	for (i = 0; i < graph.vertices; i++)
+		graph.first_arc[i + 1] += graph.first_arc[i];
+	vector<int> next(graph.first_arc.begin(), graph.first_arc.end() - 1);
+	for (i = 0; i < (int)from.size(); i++)
+	{
+		graph.arc_to[next[from[i]]] = to[i];
+		graph.arc_weight[next[from[i]]++] = weight[i];
+	}
+	return true;
+}
+
+void writeEdge(FILE *out, int u, int v)
+{
+	int w = rand() % 1000 + 1;
+	fprintf(out, "a %d %d %d\na %d %d %d\n", u + 1, v + 1, w, v + 1, u + 1, w);
+}
+
+// A path through all vertices keeps the graph connected; the remaining
+// edges join random pairs.
+void writeRandom(FILE *out, int n, int m)
+{
+	int i;
+	fprintf(out, "c random graph\np sp %d %d\n", n, 2 * m);
+	for (i = 0; i + 1 < n && i < m; i++)
+		writeEdge(out, i, i + 1);
+	for (; i < m; i++)
+		writeEdge(out, rand() % n, rand() % n);
+}
+
+void writeGrid(FILE *out, int rows, int cols)
+{
+	int r, c;
+	fprintf(out, "c grid graph\np sp %d %d\n", rows * cols, 2 * (rows * (cols - 1) + (rows - 1) * cols));
+	for (r = 0; r < rows; r++)
+		for (c = 0; c < cols; c++)
+		{
+			if (c + 1 < cols)
+				writeEdge(out, r * cols + c, r * cols + c + 1);
+			if (r + 1 < rows)
+				writeEdge(out, r * cols + c, (r + 1) * cols + c);
+		}
+}
+
+/**
+* Uniform interface over the heaps. Handle is the type returned by push;
+* lazy is true when decrease cannot be used and stale entries are skipped.
+*/
+template <template <class> class Allocator> struct BinomialQueue
+{
+	static const bool lazy = false;
+	typedef BinomialHeapNode<Entry> *Handle;
+	BinomialHeap<Entry, Allocator> heap;
+	Handle push(const Entry &entry) { return heap.push(entry); }
+	Entry pop() { return heap.extractMin(); }
+	void decrease(Handle handle, const Entry &entry) { heap.decreaseKey(handle, entry); }
+	bool empty() const { return heap.getSize() == 0; }
+	long long allocations() const { return heap.getAllocationCount(); }
+	long long memory() const { return heap.getPeakNodeMemory(); }
+};
+
+template <template <class> class Allocator> struct FibonacciQueue
+{
+	static const bool lazy = false;
+	typedef FibonacciHeapNode<Entry> *Handle;
+	FibonacciHeap<Entry, Allocator> heap;
+	Handle push(const Entry &entry) { return heap.insert(entry); }
+	Entry pop() { return heap.extractMin(); }
+	void decrease(Handle handle, const Entry &entry) { heap.decreaseKey(handle, entry); }
+	bool empty() const { return heap.getSize() == 0; }
+	long long allocations() const { return heap.getAllocationCount(); }
+	long long memory() const { return heap.getPeakNodeMemory(); }
+};
+
+template <template <class> class Allocator> struct PairingQueue
+{
+	static const bool lazy = false;
+	typedef PairingHeapNode<Entry> *Handle;
+	PairingHeap<Entry, Allocator> heap;
+	Handle push(const Entry &entry) { return heap.insert(entry); }
+	Entry pop() { return heap.extractMin(); }
+	void decrease(Handle handle, const Entry &entry) { heap.decreaseKey(handle, entry); }
+	bool empty() const { return heap.getSize() == 0; }
+	long long allocations() const { return heap.getAllocationCount(); }
+	long long memory() const { return heap.getPeakNodeMemory(); }
+};
+
+template <template <class> class Allocator> struct SkewQueue
+{
+	static const bool lazy = true;
+	typedef int Handle;
+	SkewHeap<Entry, Allocator> heap;
+	Handle push(const Entry &entry) { heap.add(entry); return 0; }
+	Entry pop() { return heap.removeMin(); }
+	void decrease(Handle, const Entry &) { }
+	bool empty() const { return heap.empty(); }
+	long long allocations() const { return heap.getAllocationCount(); }
+	long long memory() const { return heap.getPeakNodeMemory(); }
+};
+
+// Not a template over the allocator: the d-ary heap keeps its elements in
+// vectors, and its integer handles stay valid until extraction.
+struct DaryQueue
+{
+	static const bool lazy = false;
+	typedef int Handle;
+	DaryHeap<Entry, 4> heap;
+	Handle push(const Entry &entry) { return heap.insert(entry); }
+	Entry pop() { return heap.extractMin(); }
+	void decrease(Handle handle, const Entry &entry) { heap.decreaseKey(handle, entry); }
+	bool empty() const { return heap.getSize() == 0; }
+	long long allocations() const { return 0; }
+	long long memory() const { return 0; }
+};
+
+// Not a template over the allocator either, for the same reason. The vertex
+// of each handle is kept next to the heap, as the heap itself only stores
+// the distances.
+struct RadixQueue
+{
+	static const bool lazy = false;
+	typedef int Handle;
+	RadixHeap<unsigned long long> heap;
+	vector<int> vertex;
+	Handle push(const Entry &entry)
+	{
+		Handle handle = heap.insert(entry.first);
+		if (handle >= (int)vertex.size())
+			vertex.resize(handle + 1);
+		vertex[handle] = entry.second;
+		return handle;
+	}
+	Entry pop()
+	{
+		Handle handle;
+		long long key = heap.extractMin(handle);
+		return Entry(key, vertex[handle]);
+	}
+	void decrease(Handle handle, const Entry &entry) { heap.decreaseKey(handle, entry.first); }
+	bool empty() const { return heap.getSize() == 0; }
+	long long allocations() const { return 0; }
+	long long memory() const { return 0; }
+};
+
+enum Operation
+{
+	PUSH,
+	DECREASE,
+	POP,
+	OPERATIONS
+};
+
+const char *operation_names[OPERATIONS] = { "push", "decreaseKey", "extractMin" };
+
+/**
+* Counts the heap operations of one run and, when profile is set, times each
+* of them separately.
+*/
+struct Stats
+{
+	bool profile;
+	long long count[OPERATIONS];
+	double seconds[OPERATIONS];
+	chrono::steady_clock::time_point started;
+
+	Stats(bool profile_operations)
+	{
+		profile = profile_operations;
+		for (int i = 0; i < OPERATIONS; i++)
+		{
+			count[i] = 0;
+			seconds[i] = 0;
+		}
+	}
+
+	void start()
+	{
+		if (profile)
+			started = chrono::steady_clock::now();
+	}
+
+	void stop(Operation operation)
+	{
+		count[operation]++;
+		if (profile)
+			seconds[operation] += chrono::duration<double>(chrono::steady_clock::now() - started).count();
+	}
+};
+
+/**
+* Dijkstra (prim = false) or Prim (prim = true) from source. The two differ
+* only in the key offered to a neighbour: the distance through u, or the
+* weight of the arc. Returns the sum of the final keys as a checksum.
+*/
+template <class Queue> long long run(const Graph &graph, int source, bool prim, Queue &queue, Stats &stats)
+{
+	vector<long long> key(graph.vertices, -1);
+	vector<typename Queue::Handle> handle(graph.vertices);
+	vector<bool> done(graph.vertices, false);
+	long long checksum = 0, candidate;
+	Entry top;
+	int u, v, a;
+	key[source] = 0;
+	stats.start();
+	handle[source] = queue.push(Entry(0, source));
+	stats.stop(PUSH);
+	while (!queue.empty())
+	{
+		stats.start();
+		top = queue.pop();
+		stats.stop(POP);
+		u = top.second;
+		if (done[u])
+			continue;
+		done[u] = true;
+		checksum += key[u];
+		for (a = graph.first_arc[u]; a < graph.first_arc[u + 1]; a++)
+		{
+			v = graph.arc_to[a];
+			if (done[v])
+				continue;
+			candidate = prim ? graph.arc_weight[a] : key[u] + graph.arc_weight[a];
+			if (key[v] != -1 && key[v] <= candidate)
+				continue;
+			stats.start();
+			if (key[v] == -1 || Queue::lazy)
+			{
+				handle[v] = queue.push(Entry(candidate, v));
+				stats.stop(PUSH);
+			}
+			else
+			{
+				queue.decrease(handle[v], Entry(candidate, v));
+				stats.stop(DECREASE);
+			}
+			key[v] = candidate;
+		}
+	}
+	return checksum;
+}
+
+template <class Queue> void benchmark(const Graph &graph, int source, bool prim, const char *name)
+{
+	long long checksum;
+	double elapsed;
+	int i;
+	Stats plain(false), profiled(true);
+	{
+		Queue queue;
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		checksum = run(graph, source, prim, queue, plain);
+		elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+		fprintf(stdout, "%s %-10s %.3lfs, checksum %lld, %lld slab allocations, peak node memory %.1lf MB\n",
+			prim ? "prim    " : "dijkstra", name, elapsed, checksum, queue.allocations(),
+			queue.memory() / 1048576.0);
+	}
+	{
+		Queue queue;
+		run(graph, source, prim, queue, profiled);
+		fprintf(stdout, "         %-10s", "");
+		for (i = 0; i < OPERATIONS; i++)
+			if (profiled.count[i] > 0)
+				fprintf(stdout, " %s %lld x %.1lfns", operation_names[i], profiled.count[i],
+					profiled.seconds[i] * 1e9 / profiled.count[i]);
+		fprintf(stdout, "\n");
+	}
+}
+
+void benchmarkAll(const Graph &graph, int source, bool prim)
+{
+	benchmark<BinomialQueue<NodePool> >(graph, source, prim, "binomial");
+	benchmark<FibonacciQueue<NodePool> >(graph, source, prim, "fibonacci");
+	benchmark<PairingQueue<NodePool> >(graph, source, prim, "pairing");
+	benchmark<SkewQueue<NodePool> >(graph, source, prim, "skew");
+	benchmark<DaryQueue>(graph, source, prim, "4-ary");
+	if (!prim)
+		benchmark<RadixQueue>(graph, source, prim, "radix");
+}
+
+int main(int argc, char *argv[])
+{
+	Graph graph;
+	FILE *out;
+	struct rusage usage;
+	int source;
+	srand(42);
+	if (argc == 5 && (strcmp(argv[1], "--random") == 0 || strcmp(argv[1], "--grid") == 0))
+	{
+		out = fopen(argv[4], "w");
+		if (out == NULL)
+		{
+			fprintf(stderr, "Cannot write %s\n", argv[4]);
+			return 1;
+		}
+		if (strcmp(argv[1], "--random") == 0)
+			writeRandom(out, atoi(argv[2]), atoi(argv[3]));
+		else
+			writeGrid(out, atoi(argv[2]), atoi(argv[3]));
+		fclose(out);
+		return 0;
+	}
+	if (argc < 2)
+	{
+		fprintf(stderr, "Usage: %s graph.gr [source] | --random n m out.gr | --grid rows cols out.gr\n", argv[0]);
+		return 1;
+	}
+	if (!readDimacs(argv[1], graph))
+		return 1;
+	source = argc > 2 ? atoi(argv[2]) - 1 : 0;
+	if (source < 0 || source >= graph.vertices)
+	{
+		fprintf(stderr, "The source must be a vertex in [1, %d]\n", graph.vertices);
+		return 1;
+	}
+	fprintf(stdout, "%d vertices, %d arcs, source %d\n", graph.vertices, (int)graph.arc_to.size(), source + 1);
+	benchmarkAll(graph, source, false);
+	benchmarkAll(graph, source, true);
+	getrusage(RUSAGE_SELF, &usage);
+	fprintf(stdout, "peak resident set size: %.1lf MB\n", usage.ru_maxrss / 1024.0);
+	return 0;
+}
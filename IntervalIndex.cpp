@@ -0,0 +1,501 @@
+/**
+* Interval Index implementation in C++
+* @keywords: Data Structures, Interval overlap, Stabbing queries
+*
+* Stores intervals [lo, hi] with payloads and reports all intervals that
+* contain a point (stabbing query) or overlap an interval (overlap query).
+* Unlike IntervalTree, which is a segment tree over array indices, these are
+* interval trees in the classic sense: search trees ordered by lo, where every
+* node also keeps the largest hi in its subtree, so whole subtrees that end
+* before the query are skipped.
+*
+* IntervalIndex is a treap and supports insert and erase; it is built in O(n)
+* from intervals sorted by lo. StaticIntervalIndex keeps the sorted intervals
+* in a flat array and uses the array itself as an implicit binary search tree,
+* so a query reads contiguous memory and follows no pointers.
+*/
+
+#ifndef __INTERVAL_INDEX_H__
+#define __INTERVAL_INDEX_H__
+
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+#include "NodePool.h"
+using namespace std;
+
+template <typename Key, typename Payload> struct Interval {
+	Key lo, hi;
+	Payload payload;
+};
+
+template <typename Key, typename Payload> bool lowerStart(const Interval<Key, Payload> &a, const Interval<Key, Payload> &b) {
+	return a.lo < b.lo;
+}
+
+template <typename Key, typename Payload, template <class> class Allocator = NodePool> class IntervalIndex {
+public:
+
+	typedef Interval<Key, Payload> Item;
+
+	IntervalIndex() {
+		root = NULL;
+		size = 0;
+		state = 88172645463325252ULL;
+	}
+
+	/**
+	* Creates an index of intervals, which must be sorted by lo, in O(n).
+	*/
+	IntervalIndex(const vector<Item> &sorted) {
+		vector<Node *> spine;
+		Node *node, *last;
+		int i;
+		root = NULL;
+		size = sorted.size();
+		state = 88172645463325252ULL;
+		// The treap of sorted keys is their Cartesian tree by priority. Its
+		// right spine is kept on a stack while the keys are appended.
+		for (i = 0; i < size; i++) {
+			node = allocator.allocate(sorted[i], nextPriority());
+			last = NULL;
+			while (!spine.empty() && spine.back()->priority < node->priority) {
+				last = spine.back();
+				spine.pop_back();
+			}
+			node->left = last;
+			if (spine.empty())
+				root = node;
+			else
+				spine.back()->right = node;
+			spine.push_back(node);
+		}
+		updateSubtree(root);
+	}
+
+	~IntervalIndex() {
+		if (!Allocator<Node>::releases_in_bulk || !is_trivially_destructible<Item>::value)
+			deleteSubtree(root);
+	}
+
+	void insert(const Item &item) {
+		root = insert(root, allocator.allocate(item, nextPriority()));
+		size++;
+	}
+
+	/**
+	* Removes one interval [lo, hi]. Returns false if there is none.
+	*/
+	bool erase(const Key &lo, const Key &hi) {
+		bool erased = false;
+		root = erase(root, lo, hi, erased);
+		if (erased)
+			size--;
+		return erased;
+	}
+
+	/**
+	* Calls report(item) for every interval that overlaps [lo, hi], and
+	* returns their number.
+	*/
+	template <class Function> int overlap(const Key &lo, const Key &hi, Function report) const {
+		return overlap(root, lo, hi, report);
+	}
+
+	/**
+	* Calls report(item) for every interval that contains point, and returns
+	* their number.
+	*/
+	template <class Function> int stab(const Key &point, Function report) const {
+		return overlap(root, point, point, report);
+	}
+
+	int getSize() const {
+		return size;
+	}
+
+	long long getPeakNodeMemory() const {
+		return allocator.getPeakBytes();
+	}
+
+private:
+
+	struct Node {
+		Item item;
+		// The largest hi in the subtree.
+		Key max_hi;
+		unsigned priority;
+		Node *left, *right;
+
+		Node(const Item &item, unsigned priority) : item(item), max_hi(item.hi), priority(priority), left(NULL), right(NULL) {
+		}
+	};
+
+	IntervalIndex(const IntervalIndex &);
+	IntervalIndex &operator=(const IntervalIndex &);
+
+	unsigned nextPriority() {
+		state ^= state << 13;
+		state ^= state >> 7;
+		state ^= state << 17;
+		return state >> 32;
+	}
+
+	static void pull(Node *node) {
+		node->max_hi = node->item.hi;
+		if (node->left != NULL && node->max_hi < node->left->max_hi)
+			node->max_hi = node->left->max_hi;
+		if (node->right != NULL && node->max_hi < node->right->max_hi)
+			node->max_hi = node->right->max_hi;
+	}
+
+	static void updateSubtree(Node *node) {
+		if (node == NULL)
+			return;
+		updateSubtree(node->left);
+		updateSubtree(node->right);
+		pull(node);
+	}
+
+	static Node *rotateRight(Node *node) {
+		Node *left = node->left;
+		node->left = left->right;
+		left->right = node;
+		pull(node);
+		pull(left);
+		return left;
+	}
+
+	static Node *rotateLeft(Node *node) {
+		Node *right = node->right;
+		node->right = right->left;
+		right->left = node;
+		pull(node);
+		pull(right);
+		return right;
+	}
+
+	static Node *insert(Node *node, Node *added) {
+		if (node == NULL)
+			return added;
+		if (added->item.lo < node->item.lo) {
+			node->left = insert(node->left, added);
+			if (node->left->priority > node->priority)
+				return rotateRight(node);
+		} else {
+			node->right = insert(node->right, added);
+			if (node->right->priority > node->priority)
+				return rotateLeft(node);
+		}
+		pull(node);
+		return node;
+	}
+
+	// Joins two treaps where every key of left is not larger than those of
+	// right.
+	static Node *join(Node *left, Node *right) {
+		if (left == NULL)
+			return right;
+		if (right == NULL)
+			return left;
+		if (left->priority > right->priority) {
+			left->right = join(left->right, right);
+			pull(left);
+			return left;
+		}
+		right->left = join(left, right->left);
+		pull(right);
+		return right;
+	}
+
+	Node *erase(Node *node, const Key &lo, const Key &hi, bool &erased) {
+		Node *result;
+		if (node == NULL || node->max_hi < hi)
+			return node;
+		if (!(lo < node->item.lo) && !(node->item.lo < lo) && !(hi < node->item.hi) && !(node->item.hi < hi)) {
+			result = join(node->left, node->right);
+			allocator.deallocate(node);
+			erased = true;
+			return result;
+		}
+		// Equal starts may be on both sides after rotations.
+		if (!(node->item.lo < lo))
+			node->left = erase(node->left, lo, hi, erased);
+		if (!erased && !(lo < node->item.lo))
+			node->right = erase(node->right, lo, hi, erased);
+		pull(node);
+		return node;
+	}
+
+	template <class Function> static int overlap(const Node *node, const Key &lo, const Key &hi, Function &report) {
+		int count = 0;
+		// Nothing in the subtree reaches lo.
+		while (node != NULL && !(node->max_hi < lo)) {
+			count += overlap(node->left, lo, hi, report);
+			// Nodes to the right start after this one.
+			if (hi < node->item.lo)
+				break;
+			if (!(node->item.hi < lo)) {
+				report(node->item);
+				count++;
+			}
+			node = node->right;
+		}
+		return count;
+	}
+
+	void deleteSubtree(Node *node) {
+		if (node == NULL)
+			return;
+		deleteSubtree(node->left);
+		deleteSubtree(node->right);
+		allocator.deallocate(node);
+	}
+
+	Node *root;
+	int size;
+	unsigned long long state;
+	Allocator<Node> allocator;
+};
+
+template <typename Key, typename Payload> class StaticIntervalIndex {
+public:
+
+	typedef Interval<Key, Payload> Item;
+
+	/**
+	* Creates an index of intervals, which must be sorted by lo, in O(n).
+	*/
+	StaticIntervalIndex(const vector<Item> &sorted) : items(sorted), max_hi(sorted.size()) {
+		build();
+	}
+
+	/**
+	* Calls report(item) for every interval that overlaps [lo, hi], and
+	* returns their number.
+	*/
+	template <class Function> int overlap(const Key &lo, const Key &hi, Function report) const {
+		struct Visit {
+			int node, level;
+			bool left_done;
+		} stack[64], visit;
+		int size = items.size(), top = 0, count = 0, child, i, end;
+		if (size == 0)
+			return 0;
+		stack[top].node = (1 << max_level) - 1;
+		stack[top].level = max_level;
+		stack[top++].left_done = false;
+		while (top > 0) {
+			visit = stack[--top];
+			if (visit.level <= LINEAR_LEVELS) {
+				// A small subtree is a contiguous range; scan it in order.
+				i = visit.node >> visit.level << visit.level;
+				end = min(size, i + (1 << (visit.level + 1)) - 1);
+				for (; i < end && !(hi < items[i].lo); i++)
+					if (!(items[i].hi < lo)) {
+						report(items[i]);
+						count++;
+					}
+			} else if (!visit.left_done) {
+				visit.left_done = true;
+				stack[top++] = visit;
+				child = visit.node - (1 << (visit.level - 1));
+				// A child past the end of the array may still have children
+				// inside it, so it is always visited.
+				if (child >= size || !(max_hi[child] < lo)) {
+					stack[top].node = child;
+					stack[top].level = visit.level - 1;
+					stack[top++].left_done = false;
+				}
+			} else if (visit.node < size && !(hi < items[visit.node].lo)) {
+				if (!(items[visit.node].hi < lo)) {
+					report(items[visit.node]);
+					count++;
+				}
+				stack[top].node = visit.node + (1 << (visit.level - 1));
+				stack[top].level = visit.level - 1;
+				stack[top++].left_done = false;
+			}
+		}
+		return count;
+	}
+
+	template <class Function> int stab(const Key &point, Function report) const {
+		return overlap(point, point, report);
+	}
+
+	int getSize() const {
+		return items.size();
+	}
+
+	long long getMemory() const {
+		return items.size() * (long long)(sizeof(Item) + sizeof(Key));
+	}
+
+private:
+
+	// Subtrees of up to 2^(LINEAR_LEVELS + 1) - 1 intervals are scanned.
+	static const int LINEAR_LEVELS = 3;
+
+	// The implicit tree: the node at index i has level k if the lowest k bits
+	// of i are ones and the next bit is zero. Its children are i - 2^(k - 1)
+	// and i + 2^(k - 1), and its subtree is the range of indices that agree
+	// with i above bit k. Leaves are at even indices.
+	void build() {
+		int size = items.size(), i, j, level, step;
+		Key right_max;
+		max_level = 0;
+		for (i = 0; i < size; i += 2)
+			max_hi[i] = items[i].hi;
+		for (level = 1; 1 << level <= size; level++) {
+			step = 1 << (level - 1);
+			for (i = (step << 1) - 1; i < size; i += step << 2) {
+				if (i + step < size)
+					right_max = max_hi[i + step];
+				else {
+					// The right child is past the end of the array, but some
+					// of its subtree may not be. This happens once per level.
+					right_max = items[i].hi;
+					for (j = i + 1; j < size; j++)
+						right_max = max(right_max, items[j].hi);
+				}
+				max_hi[i] = max(items[i].hi, max(max_hi[i - step], right_max));
+			}
+			max_level = level;
+		}
+	}
+
+	vector<Item> items;
+	// The largest hi in the subtree of each index.
+	vector<Key> max_hi;
+	int max_level;
+};
+
+#endif // #ifndef __INTERVAL_INDEX_H__
+
+
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+
+const int NUM_INTERVALS = 10000000;
+const int MAX_COORDINATE = 1000000000;
+const int MAX_LENGTH = 1000;
+const int NUM_QUERIES = 1 << 20;
+// The linear scan is only run on a few queries.
+const int NUM_SCANNED = 64;
+// Dynamic inserts and erases are measured on a smaller index.
+const int NUM_INSERTED = 1 << 20;
+
+typedef Interval<int, int> Item;
+
+unsigned state = 42;
+
+int rand30() {
+	state = state * 1103515245 + 12345;
+	return state >> 2;
+}
+
+void randomInterval(int &lo, int &hi) {
+	lo = rand30() % MAX_COORDINATE;
+	hi = lo + rand30() % MAX_LENGTH;
+}
+
+// Sums the payloads of the reported intervals.
+struct Checksum {
+	long long *sum;
+
+	void operator()(const Item &item) const {
+		*sum += item.payload;
+	}
+};
+
+double secondsSince(chrono::steady_clock::time_point start) {
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+int main(void) {
+	vector<Item> items(NUM_INTERVALS);
+	vector<int> query_lo(NUM_QUERIES), query_hi(NUM_QUERIES);
+	long long sums[3] = { 0, 0, 0 }, counts[3] = { 0, 0, 0 }, scanned_sum = 0, scanned_count = 0;
+	Checksum checksum;
+	int i, j;
+	bool correct = true;
+
+	for (i = 0; i < NUM_INTERVALS; i++) {
+		randomInterval(items[i].lo, items[i].hi);
+		items[i].payload = i;
+	}
+	for (i = 0; i < NUM_QUERIES; i++)
+		randomInterval(query_lo[i], query_hi[i]);
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	sort(items.begin(), items.end(), lowerStart<int, int>);
+	fprintf(stdout, "%d intervals sorted in %.3lfs\n", NUM_INTERVALS, secondsSince(start));
+
+	start = chrono::steady_clock::now();
+	StaticIntervalIndex<int, int> flat(items);
+	double build_elapsed = secondsSince(start);
+	checksum.sum = &sums[0];
+	start = chrono::steady_clock::now();
+	for (i = 0; i < NUM_QUERIES; i++)
+		counts[0] += flat.overlap(query_lo[i], query_hi[i], checksum);
+	double query_elapsed = secondsSince(start);
+	fprintf(stdout, "Flat index: built in %.3lfs, %.1lf MB, %.2lf Mqueries/s, %.2lf overlaps per query\n",
+		build_elapsed, flat.getMemory() / 1048576.0, NUM_QUERIES / query_elapsed / 1e6, (double)counts[0] / NUM_QUERIES);
+
+	start = chrono::steady_clock::now();
+	IntervalIndex<int, int> treap(items);
+	build_elapsed = secondsSince(start);
+	checksum.sum = &sums[1];
+	start = chrono::steady_clock::now();
+	for (i = 0; i < NUM_QUERIES; i++)
+		counts[1] += treap.overlap(query_lo[i], query_hi[i], checksum);
+	query_elapsed = secondsSince(start);
+	fprintf(stdout, "Treap index: built in %.3lfs, %.1lf MB, %.2lf Mqueries/s\n",
+		build_elapsed, treap.getPeakNodeMemory() / 1048576.0, NUM_QUERIES / query_elapsed / 1e6);
+
+	checksum.sum = &sums[2];
+	start = chrono::steady_clock::now();
+	for (i = 0; i < NUM_QUERIES; i++)
+		counts[2] += flat.stab(query_lo[i], checksum);
+	query_elapsed = secondsSince(start);
+	fprintf(stdout, "Flat index stabbing: %.2lf Mqueries/s, %.2lf intervals per point\n",
+		NUM_QUERIES / query_elapsed / 1e6, (double)counts[2] / NUM_QUERIES);
+
+	if (counts[0] != counts[1] || sums[0] != sums[1])
+		correct = false;
+
+	// The linear scan the indexes replace.
+	start = chrono::steady_clock::now();
+	for (i = 0; i < NUM_SCANNED; i++)
+		for (j = 0; j < NUM_INTERVALS; j++)
+			if (items[j].lo <= query_hi[i] && query_lo[i] <= items[j].hi) {
+				scanned_sum += items[j].payload;
+				scanned_count++;
+			}
+	query_elapsed = secondsSince(start);
+	fprintf(stdout, "Linear scan: %.2lf queries/s\n", NUM_SCANNED / query_elapsed);
+	sums[0] = 0;
+	counts[0] = 0;
+	checksum.sum = &sums[0];
+	for (i = 0; i < NUM_SCANNED; i++)
+		counts[0] += flat.overlap(query_lo[i], query_hi[i], checksum);
+	if (counts[0] != scanned_count || sums[0] != scanned_sum)
+		correct = false;
+
+	IntervalIndex<int, int> dynamic;
+	start = chrono::steady_clock::now();
+	for (i = 0; i < NUM_INSERTED; i++)
+		dynamic.insert(items[i * (NUM_INTERVALS / NUM_INSERTED)]);
+	double insert_elapsed = secondsSince(start);
+	start = chrono::steady_clock::now();
+	for (i = 0; i < NUM_INSERTED; i += 2)
+		if (!dynamic.erase(items[i * (NUM_INTERVALS / NUM_INSERTED)].lo, items[i * (NUM_INTERVALS / NUM_INSERTED)].hi))
+			correct = false;
+	double erase_elapsed = secondsSince(start);
+	fprintf(stdout, "Treap index: %d inserts %.2lf Mops/s, %d erases %.2lf Mops/s, %d left\n",
+		NUM_INSERTED, NUM_INSERTED / insert_elapsed / 1e6, NUM_INSERTED / 2, NUM_INSERTED / 2 / erase_elapsed / 1e6,
+		dynamic.getSize());
+	fprintf(stdout, "Results are %s.\n", correct ? "correct" : "incorect");
+	return 0;
+}
@@ -7,23 +7,484 @@
 * Implement a dynamic RMQ with interval query and update. The update should
 * add a certain value to all cells in a given interval, while the query should
 * return the maximum value inside an interval.
+*
+* The query and the update are policies: a Monoid combines the values of an
+* interval, and an Action changes all values of an interval. By default they
+* are max and add.
 */
 
 #ifndef __INTERVAL_TREE_H__
 #define __INTERVAL_TREE_H__
 
 #include <algorithm>
+#include <cassert>
+#include <limits>
+#include <thread>
 #include <vector>
 using namespace std;
 
-template <typename T> class IntervalTree {
+/**
+* A Monoid has an identity, an associative combine, and repeat, the combination
+* of length copies of a value.
+*/
+template <typename T> struct MaxMonoid {
+	static T identity() {
+		return numeric_limits<T>::lowest();
+	}
+
+	static T combine(const T &a, const T &b) {
+		return max(a, b);
+	}
+
+	static T repeat(const T &value, int /*length*/) {
+		return value;
+	}
+};
+
+template <typename T> struct MinMonoid {
+	static T identity() {
+		return numeric_limits<T>::max();
+	}
+
+	static T combine(const T &a, const T &b) {
+		return min(a, b);
+	}
+
+	static T repeat(const T &value, int /*length*/) {
+		return value;
+	}
+};
+
+template <typename T> struct SumMonoid {
+	static T identity() {
+		return T();
+	}
+
+	static T combine(const T &a, const T &b) {
+		return a + b;
+	}
+
+	static T repeat(const T &value, int length) {
+		return value * length;
+	}
+};
+
+/**
+* An Action has an Update type with an identity, compose(newer, older) which
+* gives the update doing older and then newer, and apply, the combination of
+* length values after the update, given their combination before it.
+* commutative tells whether updates may be composed in any order; if not, the
+* tree pushes pending updates down before it stores a newer one.
+*/
+template <typename T> struct AddAction {
+	typedef T Update;
+
+	static const bool commutative = true;
+
+	static Update identity() {
+		return T();
+	}
+
+	static bool isIdentity(const Update &add) {
+		return add == T();
+	}
+
+	static Update compose(const Update &newer, const Update &older) {
+		return newer + older;
+	}
+
+	template <class Monoid> static T apply(const Update &add, const T &value, int length) {
+		return value + Monoid::repeat(add, length);
+	}
+};
+
+template <typename T> struct AssignAction {
+	struct Update {
+		bool assigned;
+		T value;
+	};
+
+	static const bool commutative = false;
+
+	static Update identity() {
+		Update update = { false, T() };
+		return update;
+	}
+
+	static bool isIdentity(const Update &update) {
+		return !update.assigned;
+	}
+
+	static Update compose(const Update &newer, const Update &older) {
+		return newer.assigned ? newer : older;
+	}
+
+	template <class Monoid> static T apply(const Update &update, const T &value, int length) {
+		return update.assigned ? Monoid::repeat(update.value, length) : value;
+	}
+};
+
+// Replaces every value x by multiply * x + add. With max or min, multiply
+// must not be negative.
+template <typename T> struct AffineAction {
+	struct Update {
+		T multiply, add;
+	};
+
+	static const bool commutative = false;
+
+	static Update identity() {
+		Update update = { T(1), T() };
+		return update;
+	}
+
+	static bool isIdentity(const Update &update) {
+		return update.multiply == T(1) && update.add == T();
+	}
+
+	static Update compose(const Update &newer, const Update &older) {
+		Update update = { newer.multiply * older.multiply, newer.multiply * older.add + newer.add };
+		return update;
+	}
+
+	template <class Monoid> static T apply(const Update &update, const T &value, int length) {
+		return update.multiply * value + Monoid::repeat(update.add, length);
+	}
+};
+
+template <typename T, class Monoid = MaxMonoid<T>, class Action = AddAction<T> > class IntervalTree {
 public:
 
+	typedef typename Action::Update Update;
+
+	/**
+	* An operation of a batch: a query of [idx1, idx2], or an update applying
+	* change to it.
+	*/
+	struct Operation {
+		int idx1, idx2;
+		Update change;
+		bool query;
+	};
+
 	/**
 	* Creates a new interval tree with initial values given in values.
 	* Each update and query should allow indices [0, values.size() - 1].
 	*/
 	IntervalTree(const vector<T>& values) {
+		int i;
+		interval_size = values.size();
+		// The leaves are padded to a power of two, so every node covers a
+		// contiguous block of indices and its children are 2 * pos, 2 * pos + 1.
+		leaves = 1;
+		height = 0;
+		while (leaves < interval_size) {
+			leaves <<= 1;
+			height++;
+		}
+		tree = new T[leaves << 1];
+		lazy = new Update[leaves];
+		for (i = 0; i < leaves; i++) {
+			tree[leaves + i] = i < interval_size ? values[i] : Monoid::identity();
+			lazy[i] = Action::identity();
+		}
+		for (i = leaves - 1; i > 0; i--)
+			tree[i] = Monoid::combine(tree[i << 1], tree[(i << 1) + 1]);
+	}
+
+	~IntervalTree() {
+		delete[] tree;
+		delete[] lazy;
+	}
+
+	/**
+	* Applies change to each element in the interval [idx1, idx2]; by default
+	* adds it.
+	*/
+	void update(int idx1, int idx2, const Update &change) {
+		prepare(idx1, idx2);
+		applyRange(idx1, idx2, change);
+		rebuild(idx1 + leaves);
+		rebuild(idx2 + leaves);
+	}
+
+	/**
+	* Returns the combination of the values in the interval [idx1, idx2]; by
+	* default their maximum.
+	* The query does not write to the tree, so any number of threads may run
+	* queries at the same time as long as no update runs concurrently.
+	*/
+	T query(int idx1, int idx2) const {
+		T left_result = Monoid::identity(), right_result = Monoid::identity();
+		int left_length = 0, right_length = 0, length = 1;
+		int left = idx1 + leaves, right = idx2 + leaves + 1, node;
+		// The pending updates are never pushed down (mark permanence) but
+		// applied on the way up. After each step every node taken on the left
+		// border lies under left - 1, and every node taken on the right under
+		// right. The ancestors' updates are newer than everything below them.
+		while (left < right) {
+			if (left & 1) {
+				left_result = left_length > 0 ? Monoid::combine(left_result, tree[left]) : tree[left];
+				left_length += length;
+				left++;
+			}
+			if (right & 1) {
+				right--;
+				right_result = right_length > 0 ? Monoid::combine(tree[right], right_result) : tree[right];
+				right_length += length;
+			}
+			left >>= 1;
+			right >>= 1;
+			length <<= 1;
+			if (left_length > 0)
+				left_result = Action::template apply<Monoid>(lazy[left - 1], left_result, left_length);
+			if (right_length > 0)
+				right_result = Action::template apply<Monoid>(lazy[right], right_result, right_length);
+		}
+		if (left_length > 0)
+			for (node = (left - 1) >> 1; node > 0; node >>= 1)
+				left_result = Action::template apply<Monoid>(lazy[node], left_result, left_length);
+		if (right_length > 0)
+			for (node = right >> 1; node > 0; node >>= 1)
+				right_result = Action::template apply<Monoid>(lazy[node], right_result, right_length);
+		if (right_length == 0)
+			return left_result;
+		if (left_length == 0)
+			return right_result;
+		return Monoid::combine(left_result, right_result);
+	}
+
+	/**
+	* Executes the operations in order and returns the answers of the queries,
+	* in the same order. Long runs of consecutive queries are split between
+	* up to threads threads (by default one per core), and long runs of
+	* consecutive updates are applied in a combined pass.
+	*/
+	vector<T> process(const vector<Operation> &operations, int threads = 0) {
+		vector<T> results;
+		int first, last, answered = 0;
+		for (first = 0; first < (int)operations.size(); first++)
+			if (operations[first].query)
+				answered++;
+		results.resize(answered);
+		answered = 0;
+		for (first = 0; first < (int)operations.size(); first = last) {
+			for (last = first; last < (int)operations.size() && operations[last].query == operations[first].query; last++)
+				;
+			if (operations[first].query) {
+				queryRun(&operations[first], last - first, &results[answered], threads);
+				answered += last - first;
+			} else
+				updateRun(&operations[first], last - first);
+		}
+		return results;
+	}
+
+private:
+
+	// Smaller runs of queries are not worth starting a thread for.
+	static const int MIN_QUERIES_PER_THREAD = 4096;
+	// A run of updates is applied in a combined pass if it has at least one
+	// update for every UPDATES_PER_REBUILD leaves.
+	static const int UPDATES_PER_REBUILD = 16;
+
+	// The number of leaves under pos, which must be a node (pos > 0).
+	int length(int pos) const {
+		assert(pos > 0);
+		return leaves >> depth(pos);
+	}
+
+	// The depth of pos below the root, the index of its highest set bit.
+	static int depth(int pos) {
+#ifdef __GNUC__
+		return 31 - __builtin_clz((unsigned)pos);
+#else
+		int result = -1;
+		while (pos != 0) {
+			pos >>= 1;
+			result++;
+		}
+		return result;
+#endif
+	}
+
+	// Applies change to every element under pos. tree[pos] is the result of
+	// the subtree including the update kept in lazy[pos], but not those of
+	// the ancestors of pos.
+	void apply(int pos, const Update &change) {
+		tree[pos] = Action::template apply<Monoid>(change, tree[pos], length(pos));
+		if (pos < leaves)
+			lazy[pos] = Action::compose(change, lazy[pos]);
+	}
+
+	// Applies change to the nodes covering [idx1, idx2], found bottom-up.
+	// Only their ancestors on the two borders have to be recomputed
+	// afterwards.
+	void applyRange(int idx1, int idx2, const Update &change) {
+		int left = idx1 + leaves, right = idx2 + leaves + 1;
+		for (; left < right; left >>= 1, right >>= 1) {
+			if (left & 1)
+				apply(left++, change);
+			if (right & 1)
+				apply(--right, change);
+		}
+	}
+
+	// Before an update of [idx1, idx2] the pending updates above it are
+	// moved down, unless the order of updates does not matter.
+	void prepare(int idx1, int idx2) {
+		if (!Action::commutative) {
+			push(idx1 + leaves);
+			push(idx2 + leaves);
+		}
+	}
+
+	// Moves the pending updates on the path from the root to the leaf pos
+	// down to the children.
+	void push(int pos) {
+		int shift, node;
+		for (shift = height; shift > 0; shift--) {
+			node = pos >> shift;
+			if (!Action::isIdentity(lazy[node])) {
+				apply(node << 1, lazy[node]);
+				apply((node << 1) + 1, lazy[node]);
+				lazy[node] = Action::identity();
+			}
+		}
+	}
+
+	static void queryChunk(const IntervalTree *tree, const Operation *operations, int count, T *results) {
+		int i;
+		for (i = 0; i < count; i++)
+			results[i] = tree->query(operations[i].idx1, operations[i].idx2);
+	}
+
+	void queryRun(const Operation *operations, int count, T *results, int threads) const {
+		vector<thread> workers;
+		int i, chunk;
+		if (count < MIN_QUERIES_PER_THREAD << 1) {
+			queryChunk(this, operations, count, results);
+			return;
+		}
+		if (threads == 0)
+			threads = thread::hardware_concurrency();
+		threads = min(threads, count / MIN_QUERIES_PER_THREAD);
+		if (threads <= 1) {
+			queryChunk(this, operations, count, results);
+			return;
+		}
+		chunk = (count + threads - 1) / threads;
+		// The calling thread answers the last chunk itself.
+		for (i = 0; i + chunk < count; i += chunk)
+			workers.push_back(thread(queryChunk, this, operations + i, chunk, results + i));
+		queryChunk(this, operations + i, count - i, results + i);
+		for (i = 0; i < (int)workers.size(); i++)
+			workers[i].join();
+	}
+
+	void updateRun(const Operation *operations, int count) {
+		int i;
+		// Each update recomputes the two paths to the root. For long runs it
+		// is cheaper to apply all of them first and then recompute every
+		// inner node once, in a single sequential pass over the array.
+		if (count * UPDATES_PER_REBUILD < leaves) {
+			for (i = 0; i < count; i++)
+				update(operations[i].idx1, operations[i].idx2, operations[i].change);
+			return;
+		}
+		for (i = 0; i < count; i++) {
+			prepare(operations[i].idx1, operations[i].idx2);
+			applyRange(operations[i].idx1, operations[i].idx2, operations[i].change);
+		}
+		for (i = leaves - 1; i > 0; i--)
+			recompute(i);
+	}
+
+	void recompute(int pos) {
+		tree[pos] = Action::template apply<Monoid>(lazy[pos],
+			Monoid::combine(tree[pos << 1], tree[(pos << 1) + 1]), length(pos));
+	}
+
+	// Recomputes the ancestors of the leaf pos from their children.
+	void rebuild(int pos) {
+		while (pos > 1) {
+			pos >>= 1;
+			recompute(pos);
+		}
+	}
+
+	// tree[leaves + i] is element i; lazy only exists for inner nodes.
+	T *tree;
+	Update *lazy;
+
+	int interval_size, leaves, height;
+};
+
+#endif // #ifndef __INTERVAL_TREE_H__
+
+
+#include <ctime>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+const int MAX_IDX = 65536;
+
+const int NUM_QUERIES = 65536;
+const int QUERY = 0;
+const int UPDATE = 1;
+
+struct Query {
+	int x1, x2;
+	int val, type;
+};
+
+int n;
+int init[MAX_IDX]; // Initial values
+Query a[NUM_QUERIES]; // Save queries
+int ans1[NUM_QUERIES], ans2[NUM_QUERIES], ans3[NUM_QUERIES], ans4[NUM_QUERIES]; // Save answers
+
+void solveTrees() {
+	IntervalTree <int> tree(vector<int>(init, init + MAX_IDX));
+	for (int i = 0; i < n; i++) {
+		if (a[i].type == QUERY)
+			ans1[i] = tree.query(a[i].x1, a[i].x2);
+		else {
+			ans1[i] = -1;
+			tree.update(a[i].x1, a[i].x2, a[i].val);
+		}
+	}
+}
+
+// Copies the records of a[] into operations for IntervalTree::process.
+vector<IntervalTree<int>::Operation> toOperations() {
+	vector<IntervalTree<int>::Operation> operations(n);
+	for (int i = 0; i < n; i++) {
+		operations[i].idx1 = a[i].x1;
+		operations[i].idx2 = a[i].x2;
+		operations[i].change = a[i].val;
+		operations[i].query = a[i].type == QUERY;
+	}
+	return operations;
+}
+
+void solveBatch() {
+	IntervalTree <int> tree(vector<int>(init, init + MAX_IDX));
+	vector<int> results = tree.process(toOperations());
+	for (int i = 0, j = 0; i < n; i++)
+		ans4[i] = a[i].type == QUERY ? results[j++] : -1;
+}
+
+// The previous recursive implementation, kept as a reference for the
+// execution time of the flat tree.
+template <typename T> class RecursiveIntervalTree {
+public:
+
+	// Only correct for sizes that are a power of two.
+	RecursiveIntervalTree(const vector<T>& values) {
 		int tree_size, i;
 		interval_size = values.size();
 		tree_size = interval_size << 1;
@@ -34,21 +495,15 @@ public:
 		init(values, 1, 0, interval_size - 1);
 	}
 
-	~IntervalTree() {
+	~RecursiveIntervalTree() {
 		delete[] tree;
 		delete[] lazy;
 	}
 
-	/**
-	* Adds the value add to each element in the interval [idx1, idx2].
-	*/
 	void update(int idx1, int idx2, T add) {
 		update(idx1, idx2, add, 1, 0, interval_size - 1);
 	}
 
-	/**
-	* Returns the maximum value in the interval [idx1, idx2].
-	*/
 	T query(int idx1, int idx2) {
 		return query(idx1, idx2, 1, 0, interval_size - 1);
 	}
@@ -114,38 +569,13 @@ private:
 	int interval_size;
 };
 
-#endif // #ifndef __INTERVAL_TREE_H__
-
-
-#include <ctime>
-#include <cstdio>
-#include <cstdlib>
-#include <cstring>
-#include <algorithm>
-
-const int MAX_IDX = 65536;
-
-const int NUM_QUERIES = 65536;
-const int QUERY = 0;
-const int UPDATE = 1;
-
-struct Query {
-	int x1, x2;
-	int val, type;
-};
-
-int n;
-int init[MAX_IDX]; // Initial values
-Query a[NUM_QUERIES]; // Save queries
-int ans1[NUM_QUERIES], ans2[NUM_QUERIES]; // Save answers
-
-void solveTrees() {
-	IntervalTree <int> tree(vector<int>(init, init + MAX_IDX));
+void solveRecursiveTrees() {
+	RecursiveIntervalTree <int> tree(vector<int>(init, init + MAX_IDX));
 	for (int i = 0; i < n; i++) {
 		if (a[i].type == QUERY)
-			ans1[i] = tree.query(a[i].x1, a[i].x2);
+			ans3[i] = tree.query(a[i].x1, a[i].x2);
 		else {
-			ans1[i] = -1;
+			ans3[i] = -1;
 			tree.update(a[i].x1, a[i].x2, a[i].val);
 		}
 	}
@@ -177,6 +607,151 @@ void solveDummy() {
 	}
 }
 
+const int QUERY_ROUNDS = 64;
+const int MAX_THREADS = 8;
+
+// Runs the queries with index first, first + step, ... on a shared tree.
+void runQueries(const IntervalTree<int> *tree, int first, int step, long long *checksum) {
+	long long sum = 0;
+	for (int round = 0; round < QUERY_ROUNDS; round++)
+		for (int i = first; i < n; i += step)
+			if (a[i].type == QUERY)
+				sum += tree->query(a[i].x1, a[i].x2);
+	*checksum = sum;
+}
+
+// Applies all updates, then runs the queries again and again from several
+// threads reading the same tree.
+void benchmarkConcurrentQueries() {
+	IntervalTree <int> tree(vector<int>(init, init + MAX_IDX));
+	int queries = 0;
+	for (int i = 0; i < n; i++) {
+		if (a[i].type == UPDATE)
+			tree.update(a[i].x1, a[i].x2, a[i].val);
+		else
+			queries++;
+	}
+	for (int threads = 1; threads <= MAX_THREADS; threads <<= 1) {
+		vector<thread> workers;
+		vector<long long> checksums(threads);
+		long long checksum = 0;
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		for (int i = 0; i < threads; i++)
+			workers.push_back(thread(runQueries, &tree, i, threads, &checksums[i]));
+		for (int i = 0; i < threads; i++) {
+			workers[i].join();
+			checksum += checksums[i];
+		}
+		double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+		fprintf(stdout, "Concurrent queries, %d threads: %.3lfs (%.2lf Mqueries/s), checksum %lld\n",
+			threads, elapsed, (double)QUERY_ROUNDS * queries / elapsed / 1e6, checksum);
+	}
+}
+
+const int BATCH_RUN = 16384;
+const int BATCH_ROUNDS = 16;
+
+bool isQuery(const IntervalTree<int>::Operation &operation) {
+	return operation.query;
+}
+
+// The records of a[] arrive in random order, so runs of the same type are
+// short. Here they are grouped into runs of about BATCH_RUN / 2 operations,
+// and process is compared with one call per operation on that stream.
+void benchmarkBatches() {
+	vector<IntervalTree<int>::Operation> operations = toOperations();
+	vector<int> expected, results;
+	int i, round;
+	for (i = 0; i < n; i += BATCH_RUN)
+		stable_partition(operations.begin() + i, operations.begin() + min(i + BATCH_RUN, n), isQuery);
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for (round = 0; round < BATCH_ROUNDS; round++) {
+		IntervalTree <int> tree(vector<int>(init, init + MAX_IDX));
+		expected.clear();
+		for (i = 0; i < n; i++) {
+			if (operations[i].query)
+				expected.push_back(tree.query(operations[i].idx1, operations[i].idx2));
+			else
+				tree.update(operations[i].idx1, operations[i].idx2, operations[i].change);
+		}
+	}
+	double single_elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	start = chrono::steady_clock::now();
+	for (round = 0; round < BATCH_ROUNDS; round++) {
+		IntervalTree <int> tree(vector<int>(init, init + MAX_IDX));
+		results = tree.process(operations);
+	}
+	double batch_elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	fprintf(stdout, "Runs of %d operations, one at a time: %.3lfs, batched on %d threads: %.3lfs, %s\n",
+		BATCH_RUN / 2, single_elapsed, (int)thread::hardware_concurrency(), batch_elapsed,
+		results == expected ? "same answers" : "DIFFERENT ANSWERS");
+}
+
+// The change of an update record for each action. Assignments use val
+// directly, affine updates multiply by 1 or 2 and add val.
+template <typename T> T makeChange(AddAction<T> *, const Query &query) {
+	return query.val;
+}
+
+template <typename T> typename AssignAction<T>::Update makeChange(AssignAction<T> *, const Query &query) {
+	typename AssignAction<T>::Update change = { true, (T)query.val };
+	return change;
+}
+
+template <typename T> typename AffineAction<T>::Update makeChange(AffineAction<T> *, const Query &query) {
+	typename AffineAction<T>::Update change = { (T)(1 + (query.x1 & 1)), (T)query.val };
+	return change;
+}
+
+const int NUM_CHECKED = 4096;
+const int POLICY_ROUNDS = 16;
+
+// Runs the records of a[] POLICY_ROUNDS times on a tree with the given
+// policies, and checks the first NUM_CHECKED of them against a plain array.
+template <typename T, class Monoid, class Action> void benchmarkPolicy(const char *name) {
+	vector<T> values(init, init + MAX_IDX), plain(values);
+	long long checksum = 0;
+	T result;
+	bool correct = true;
+	int i, x, round;
+	unsigned startTime = clock();
+	for (round = 0; round < POLICY_ROUNDS; round++) {
+		IntervalTree<T, Monoid, Action> tree(values);
+		for (i = 0; i < n; i++) {
+			if (a[i].type == QUERY)
+				checksum += tree.query(a[i].x1, a[i].x2);
+			else
+				tree.update(a[i].x1, a[i].x2, makeChange((Action *)NULL, a[i]));
+		}
+	}
+	double elapsed = (double)(clock() - startTime) / (double)CLOCKS_PER_SEC;
+	IntervalTree<T, Monoid, Action> checked(values);
+	for (i = 0; i < NUM_CHECKED; i++) {
+		if (a[i].type == QUERY) {
+			result = plain[a[i].x1];
+			for (x = a[i].x1 + 1; x <= a[i].x2; x++)
+				result = Monoid::combine(result, plain[x]);
+			if (checked.query(a[i].x1, a[i].x2) != result)
+				correct = false;
+		} else {
+			checked.update(a[i].x1, a[i].x2, makeChange((Action *)NULL, a[i]));
+			for (x = a[i].x1; x <= a[i].x2; x++)
+				plain[x] = Action::template apply<Monoid>(makeChange((Action *)NULL, a[i]), plain[x], 1);
+		}
+	}
+	fprintf(stdout, "%-12s %d rounds execution time: %.3lfs, checksum %lld, %s\n", name, POLICY_ROUNDS, elapsed,
+		checksum, correct ? "correct" : "incorect");
+}
+
+void benchmarkPolicies() {
+	benchmarkPolicy<int, MaxMonoid<int>, AddAction<int> >("max, add");
+	benchmarkPolicy<int, MinMonoid<int>, AddAction<int> >("min, add");
+	benchmarkPolicy<long long, SumMonoid<long long>, AddAction<long long> >("sum, add");
+	benchmarkPolicy<int, MaxMonoid<int>, AssignAction<int> >("max, assign");
+	benchmarkPolicy<long long, SumMonoid<long long>, AssignAction<long long> >("sum, assign");
+	// Unsigned, so that the repeated multiplications wrap around.
+	benchmarkPolicy<unsigned, SumMonoid<unsigned>, AffineAction<unsigned> >("sum, affine");
+}
 
 int rand30() {
 	return (((rand() & (((1 << 10) - 1) << 3)) >> 3) << 0) |
@@ -184,6 +759,74 @@ int rand30() {
 		(((rand() & (((1 << 10) - 1) << 3)) >> 3) << 20);
 }
 
+// Sizes that are not powers of two (and the smallest ones), so that the
+// padded leaves of the tree are used.
+const int ODD_SIZES[] = { 1, 2, 3, 5, 7, 13, 100, 1000, 1023, 1025 };
+// A run of queries long enough for process to split it between 4 threads.
+const int ODD_QUERY_RUN = 16384;
+// Short runs of updates are applied one by one, long ones in a combined pass.
+const int ODD_UPDATE_RUNS[] = { 8, 1024 };
+
+// Runs alternating runs of random updates and queries on a tree of size
+// elements, one at a time and with process on 4 threads, and checks every
+// answer against a plain array.
+template <typename T, class Monoid, class Action> bool checkSize(int size) {
+	typedef typename IntervalTree<T, Monoid, Action>::Operation Operation;
+	vector<T> values(init, init + size), plain(values), expected, results;
+	vector<Operation> operations;
+	IntervalTree<T, Monoid, Action> tree(values), batched(values);
+	Operation operation;
+	Query record;
+	T result;
+	bool correct = true;
+	int round, i, x;
+	for (round = 0; round < 2; round++) {
+		for (i = 0; i < ODD_UPDATE_RUNS[round] + ODD_QUERY_RUN; i++) {
+			record.x1 = rand30() % size;
+			record.x2 = rand30() % size;
+			if (record.x1 > record.x2)
+				swap(record.x1, record.x2);
+			record.val = rand30() % 20001 - 10000;
+			operation.idx1 = record.x1;
+			operation.idx2 = record.x2;
+			operation.change = makeChange((Action *)NULL, record);
+			operation.query = i >= ODD_UPDATE_RUNS[round];
+			operations.push_back(operation);
+			if (operation.query) {
+				result = plain[record.x1];
+				for (x = record.x1 + 1; x <= record.x2; x++)
+					result = Monoid::combine(result, plain[x]);
+				expected.push_back(result);
+				if (tree.query(record.x1, record.x2) != result)
+					correct = false;
+			} else {
+				tree.update(record.x1, record.x2, operation.change);
+				for (x = record.x1; x <= record.x2; x++)
+					plain[x] = Action::template apply<Monoid>(operation.change, plain[x], 1);
+			}
+		}
+	}
+	results = batched.process(operations, 4);
+	return correct && results == expected;
+}
+
+template <typename T, class Monoid, class Action> bool checkSizes() {
+	bool correct = true;
+	for (int i = 0; i < (int)(sizeof(ODD_SIZES) / sizeof(ODD_SIZES[0])); i++)
+		correct = checkSize<T, Monoid, Action>(ODD_SIZES[i]) && correct;
+	return correct;
+}
+
+void checkOddSizes() {
+	bool correct = checkSizes<int, MaxMonoid<int>, AddAction<int> >();
+	correct = checkSizes<int, MinMonoid<int>, AddAction<int> >() && correct;
+	correct = checkSizes<long long, SumMonoid<long long>, AddAction<long long> >() && correct;
+	correct = checkSizes<int, MaxMonoid<int>, AssignAction<int> >() && correct;
+	correct = checkSizes<long long, SumMonoid<long long>, AssignAction<long long> >() && correct;
+	correct = checkSizes<unsigned, SumMonoid<unsigned>, AffineAction<unsigned> >() && correct;
+	fprintf(stdout, "Sizes that are not powers of two, every policy: %s\n", correct ? "correct" : "incorect");
+}
+
 int main(void) {
 	// Generate test;
 	srand(42);
@@ -208,6 +851,18 @@ int main(void) {
 	fprintf(stdout, "Interval trees execution time: %.3lfs\n",
 		(double)(clock() - startTime) / (double)CLOCKS_PER_SEC);
 
+	// Solve with a single batch
+	startTime = clock();
+	solveBatch();
+	fprintf(stdout, "Batched interval trees execution time: %.3lfs\n",
+		(double)(clock() - startTime) / (double)CLOCKS_PER_SEC);
+
+	// Solve with the recursive interval trees
+	startTime = clock();
+	solveRecursiveTrees();
+	fprintf(stdout, "Recursive interval trees execution time: %.3lfs\n",
+		(double)(clock() - startTime) / (double)CLOCKS_PER_SEC);
+
 	// Check by dummy
 	startTime = clock();
 	solveDummy();
@@ -217,12 +872,17 @@ int main(void) {
 	int correct = 1;
 	for (int i = 0; i < n; i++) {
 		if (a[i].type == QUERY) {
-			if (ans1[i] != ans2[i]) {
+			if (ans1[i] != ans2[i] || ans3[i] != ans2[i] || ans4[i] != ans2[i]) {
 				correct = 0;
 				break;
 			}
 		}
 	}
 	fprintf(stdout, "Solution is %s.\n", correct ? "correct" : "incorect");
+
+	benchmarkConcurrentQueries();
+	benchmarkBatches();
+	benchmarkPolicies();
+	checkOddSizes();
 	return 0;
 }
@@ -0,0 +1,300 @@
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <cstdint>
+#include <atomic>
+#include <chrono>
+#include <new>
+#include <thread>
+#include <vector>
+#include "SkewHeap.h"
+#include "PairingHeap.h"
+using namespace std;
+
+/**
+* Relaxed concurrent priority queue (MultiQueue).
+*
+* The elements are spread over c * threads independent shards, each a
+* sequential heap behind a try-lock. push locks a random shard; tryPop locks
+* two random shards and takes the smaller of their minima. The popped element
+* is not always the global minimum, but its expected rank is O(threads), and
+* threads rarely wait for each other.
+*
+* Heap can be SkewHeap<T> or PairingHeap<T>.
+*/
+template <class T, class Heap = SkewHeap<T> > class MultiQueue
+{
+public:
+	MultiQueue(int threads, int c = 2);
+	~MultiQueue();
+	void push(const T &);
+	// Stores a small element in result and returns true, or returns false if
+	// the queue is empty.
+	bool tryPop(T &result);
+
+private:
+	// Every shard starts a cache line of its own, so the lock of one shard
+	// never shares a line with the heap of another.
+	struct alignas(64) Shard
+	{
+		atomic<bool> locked;
+		Heap heap;
+	};
+
+	// The memory of the shards. Before C++17 new ignores an alignment larger
+	// than that of the fundamental types, so shards is aligned inside it by
+	// hand.
+	char *storage;
+	Shard *shards;
+	int shard_count;
+
+	MultiQueue(const MultiQueue &);
+	MultiQueue &operator=(const MultiQueue &);
+	bool try_lock(Shard &);
+	void unlock(Shard &);
+	int random_shard();
+};
+
+template <class T, template <class> class Allocator> void shard_push(SkewHeap<T, Allocator> &heap, const T &value)
+{
+	heap.add(value);
+}
+
+template <class T, template <class> class Allocator> T shard_pop(SkewHeap<T, Allocator> &heap)
+{
+	return heap.removeMin();
+}
+
+template <class T, template <class> class Allocator> bool shard_empty(const SkewHeap<T, Allocator> &heap)
+{
+	return heap.empty();
+}
+
+template <class T, template <class> class Allocator> void shard_push(PairingHeap<T, Allocator> &heap, const T &value)
+{
+	heap.insert(value);
+}
+
+template <class T, template <class> class Allocator> T shard_pop(PairingHeap<T, Allocator> &heap)
+{
+	return heap.extractMin();
+}
+
+template <class T, template <class> class Allocator> bool shard_empty(const PairingHeap<T, Allocator> &heap)
+{
+	return heap.getSize() == 0;
+}
+
+template <class T, class Heap> MultiQueue<T, Heap>::MultiQueue(int threads, int c)
+{
+	int i;
+	shard_count = threads * c < 2 ? 2 : threads * c;
+	// One shard more than needed leaves room to round the start up to the
+	// alignment of a shard, as sizeof(Shard) is a multiple of it.
+	storage = new char[(shard_count + 1) * sizeof(Shard)];
+	shards = (Shard *)(((uintptr_t)storage + alignof(Shard) - 1) & ~(uintptr_t)(alignof(Shard) - 1));
+	for (i = 0; i < shard_count; i++)
+	{
+		new (&shards[i]) Shard;
+		shards[i].locked = false;
+	}
+}
+
+template <class T, class Heap> MultiQueue<T, Heap>::~MultiQueue()
+{
+	int i;
+	for (i = 0; i < shard_count; i++)
+		shards[i].~Shard();
+	delete[] storage;
+}
+
+template <class T, class Heap> bool MultiQueue<T, Heap>::try_lock(Shard &shard)
+{
+	return !shard.locked.load(memory_order_relaxed) && !shard.locked.exchange(true, memory_order_acquire);
+}
+
+template <class T, class Heap> void MultiQueue<T, Heap>::unlock(Shard &shard)
+{
+	shard.locked.store(false, memory_order_release);
+}
+
+template <class T, class Heap> int MultiQueue<T, Heap>::random_shard()
+{
+	// Per-thread xorshift generator, so threads never share random state.
+	static thread_local unsigned state = 0;
+	if (state == 0)
+		state = (unsigned)hash<thread::id>()(this_thread::get_id()) | 1;
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state % shard_count;
+}
+
+template <class T, class Heap> void MultiQueue<T, Heap>::push(const T &value)
+{
+	int i;
+	do
+		i = random_shard();
+	while (!try_lock(shards[i]));
+	shard_push(shards[i].heap, value);
+	unlock(shards[i]);
+}
+
+template <class T, class Heap> bool MultiQueue<T, Heap>::tryPop(T &result)
+{
+	const int MAX_EMPTY_ATTEMPTS = 16;
+	int empty_attempts = 0, i, j, best;
+	while (empty_attempts < MAX_EMPTY_ATTEMPTS)
+	{
+		i = random_shard();
+		j = random_shard();
+		if (!try_lock(shards[i]))
+			continue;
+		if (i == j || !try_lock(shards[j]))
+			j = -1;
+		best = -1;
+		if (!shard_empty(shards[i].heap))
+			best = i;
+		if (j != -1 && !shard_empty(shards[j].heap)
+			&& (best == -1 || shards[best].heap.getMin() > shards[j].heap.getMin()))
+			best = j;
+		if (best != -1)
+			result = shard_pop(shards[best].heap);
+		unlock(shards[i]);
+		if (j != -1)
+			unlock(shards[j]);
+		if (best != -1)
+			return true;
+		empty_attempts++;
+	}
+	// Random probes keep hitting empty shards: sweep all of them before
+	// reporting the queue as empty.
+	for (i = 0; i < shard_count; i++)
+	{
+		while (!try_lock(shards[i]))
+			this_thread::yield();
+		if (!shard_empty(shards[i].heap))
+		{
+			result = shard_pop(shards[i].heap);
+			unlock(shards[i]);
+			return true;
+		}
+		unlock(shards[i]);
+	}
+	return false;
+}
+
+const int KEY_BITS = 20;
+const int NUM_PREFILL = 1 << 20;
+const int NUM_OPERATIONS = 1 << 22;
+
+// One logged operation: the key pushed or the key returned by a pop.
+struct LogEntry
+{
+	long long ticket;
+	int key;
+	bool pop;
+};
+
+atomic<long long> next_ticket;
+
+template <class Heap> void worker(MultiQueue<int, Heap> *queue, int operations, unsigned seed, vector<LogEntry> *log)
+{
+	LogEntry entry;
+	int i, key;
+	for (i = 0; i < operations; i++)
+	{
+		seed = seed * 1103515245 + 12345;
+		if (i & 1)
+		{
+			entry.pop = true;
+			if (!queue->tryPop(key))
+				continue;
+		}
+		else
+		{
+			entry.pop = false;
+			key = (seed >> 8) & ((1 << KEY_BITS) - 1);
+			queue->push(key);
+		}
+		entry.key = key;
+		entry.ticket = next_ticket.fetch_add(1, memory_order_relaxed);
+		log->push_back(entry);
+	}
+}
+
+// Replays the logged operations in ticket order against a Fenwick tree of the
+// keys present and returns the mean number of smaller keys each pop skipped.
+// A ticket is taken after the operation and outside the shard lock, so the
+// ticket order is only close to the order the operations took effect in, and
+// the result is an approximation.
+double meanRankError(vector<vector<LogEntry> > &logs, const vector<int> &prefill)
+{
+	vector<LogEntry> all;
+	vector<int> fenwick((1 << KEY_BITS) + 1, 0);
+	long long total = 0, pops = 0;
+	int i, k, rank;
+	for (i = 0; i < (int)logs.size(); i++)
+		all.insert(all.end(), logs[i].begin(), logs[i].end());
+	vector<LogEntry> ordered(all.size());
+	for (i = 0; i < (int)all.size(); i++)
+		ordered[all[i].ticket] = all[i];
+	for (i = 0; i < (int)prefill.size(); i++)
+		for (k = prefill[i] + 1; k <= (1 << KEY_BITS); k += k & -k)
+			fenwick[k]++;
+	for (i = 0; i < (int)ordered.size(); i++)
+		if (ordered[i].pop)
+		{
+			rank = 0;
+			for (k = ordered[i].key; k > 0; k -= k & -k)
+				rank += fenwick[k];
+			total += rank;
+			pops++;
+			for (k = ordered[i].key + 1; k <= (1 << KEY_BITS); k += k & -k)
+				fenwick[k]--;
+		}
+		else
+			for (k = ordered[i].key + 1; k <= (1 << KEY_BITS); k += k & -k)
+				fenwick[k]++;
+	return pops == 0 ? 0 : (double)total / pops;
+}
+
+template <class Heap> void benchmark(const char *name, int threads)
+{
+	MultiQueue<int, Heap> queue(threads);
+	vector<int> prefill(NUM_PREFILL);
+	vector<vector<LogEntry> > logs(threads);
+	vector<thread> workers;
+	int i;
+	for (i = 0; i < NUM_PREFILL; i++)
+	{
+		prefill[i] = rand() & ((1 << KEY_BITS) - 1);
+		queue.push(prefill[i]);
+	}
+	for (i = 0; i < threads; i++)
+		logs[i].reserve(NUM_OPERATIONS / threads);
+	next_ticket = 0;
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for (i = 0; i < threads; i++)
+		workers.push_back(thread(worker<Heap>, &queue, NUM_OPERATIONS / threads, (unsigned)rand(), &logs[i]));
+	for (i = 0; i < threads; i++)
+		workers[i].join();
+	double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	// The rank error is approximate: see meanRankError.
+	fprintf(stdout, "%s, %d threads: %.3lfs, %.2lf Mops/s, approximate mean rank error %.1lf\n", name, threads, elapsed,
+		NUM_OPERATIONS / elapsed / 1e6, meanRankError(logs, prefill));
+}
+
+// Usage: MultiQueue [max_threads], defaults to the number of hardware threads.
+int main(int argc, char *argv[])
+{
+	int max_threads = argc > 1 ? atoi(argv[1]) : thread::hardware_concurrency(), threads;
+	if (max_threads < 1)
+		max_threads = 1;
+	srand(42);
+	for (threads = 1; threads <= max_threads; threads <<= 1)
+		benchmark<SkewHeap<int> >("skew heap shards", threads);
+	for (threads = 1; threads <= max_threads; threads <<= 1)
+		benchmark<PairingHeap<int> >("pairing heap shards", threads);
+	return 0;
+}
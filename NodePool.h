@@ -0,0 +1,261 @@
+/**
+* Node allocators for the mergeable heaps.
+*
+* Every heap template takes the allocator as a template template parameter and
+* instantiates it with its own node type. Both allocators expose the same
+* interface:
+*
+*	allocate(args...)  - constructs a node from args and returns it
+*	deallocate(node)   - destroys a node previously returned by allocate
+*	adopt(other)       - takes over the nodes owned by another allocator of
+*	                     the same type (used when two heaps are merged)
+*	getAllocationCount - the number of requests made to the system allocator
+*	getPeakBytes       - the largest amount of node memory held at any time
+*
+* releases_in_bulk tells the heap whether destroying the allocator is enough
+* to free the memory of all nodes still in the heap.
+*/
+
+#ifndef __NODE_POOL_H__
+#define __NODE_POOL_H__
+
+#include <cstdlib>
+#include <new>
+#include <utility>
+
+/**
+* Allocator that forwards every request to new/delete.
+*/
+template <class NodeType> class NewDeleteAllocator
+{
+public:
+	static const bool releases_in_bulk = false;
+
+	NewDeleteAllocator()
+	{
+		allocation_count = 0;
+		live_count = 0;
+		peak_count = 0;
+	}
+
+	template <class... Args> NodeType *allocate(Args&&... args)
+	{
+		allocation_count++;
+		if (++live_count > peak_count)
+			peak_count = live_count;
+		return new NodeType(std::forward<Args>(args)...);
+	}
+
+	void deallocate(NodeType *node)
+	{
+		live_count--;
+		delete node;
+	}
+
+	void adopt(NewDeleteAllocator<NodeType> &other)
+	{
+		allocation_count += other.allocation_count;
+		live_count += other.live_count;
+		if (peak_count < live_count)
+			peak_count = live_count;
+		other.allocation_count = 0;
+		other.live_count = 0;
+		other.peak_count = 0;
+	}
+
+	long long getAllocationCount() const
+	{
+		return allocation_count;
+	}
+
+	long long getPeakBytes() const
+	{
+		return peak_count * (long long)sizeof(NodeType);
+	}
+
+private:
+	long long allocation_count, live_count, peak_count;
+};
+
+/**
+* Slab allocator with an intrusive free list.
+*
+* Nodes are carved out of slabs whose size doubles up to MAX_SLAB_SIZE nodes.
+* Freed nodes go to a free list and are handed out again before the current
+* slab is touched, so a heap in steady state (as many pushes as extractions)
+* does not reach malloc at all. All slabs are freed together when the pool is
+* destroyed; destructors of nodes still alive at that point are not run.
+*/
+template <class NodeType> class NodePool
+{
+public:
+	static const bool releases_in_bulk = true;
+
+	NodePool()
+	{
+		first_slab = NULL;
+		last_slab = NULL;
+		free_list = NULL;
+		free_list_tail = NULL;
+		current = NULL;
+		current_end = NULL;
+		next_slab_size = MIN_SLAB_SIZE;
+		allocation_count = 0;
+		slab_bytes = 0;
+	}
+
+	~NodePool()
+	{
+		release();
+	}
+
+	template <class... Args> NodeType *allocate(Args&&... args)
+	{
+		Slot *slot;
+		if (free_list != NULL)
+		{
+			slot = free_list;
+			free_list = free_list->next;
+			if (free_list == NULL)
+				free_list_tail = NULL;
+		}
+		else
+		{
+			if (current == current_end)
+				grow();
+			slot = current++;
+		}
+		return new (slot->storage) NodeType(std::forward<Args>(args)...);
+	}
+
+	void deallocate(NodeType *node)
+	{
+		Slot *slot = reinterpret_cast<Slot *>(node);
+		node->~NodeType();
+		slot->next = free_list;
+		if (free_list == NULL)
+			free_list_tail = slot;
+		free_list = slot;
+	}
+
+	/**
+	* Moves all slabs and free nodes of other into this pool in O(1).
+	* The unused part of the smaller of the two current slabs is dropped; its
+	* memory is still released together with the slab.
+	*/
+	void adopt(NodePool<NodeType> &other)
+	{
+		if (other.first_slab == NULL)
+			return;
+		if (first_slab == NULL)
+			first_slab = other.first_slab;
+		else
+			last_slab->next = other.first_slab;
+		last_slab = other.last_slab;
+		if (other.free_list != NULL)
+		{
+			if (free_list == NULL)
+				free_list = other.free_list;
+			else
+				free_list_tail->next = other.free_list;
+			free_list_tail = other.free_list_tail;
+		}
+		if (other.current_end - other.current > current_end - current)
+		{
+			current = other.current;
+			current_end = other.current_end;
+		}
+		if (next_slab_size < other.next_slab_size)
+			next_slab_size = other.next_slab_size;
+		allocation_count += other.allocation_count;
+		slab_bytes += other.slab_bytes;
+		other.first_slab = NULL;
+		other.last_slab = NULL;
+		other.free_list = NULL;
+		other.free_list_tail = NULL;
+		other.current = NULL;
+		other.current_end = NULL;
+		other.next_slab_size = MIN_SLAB_SIZE;
+		other.allocation_count = 0;
+		other.slab_bytes = 0;
+	}
+
+	/**
+	* Frees all slabs at once. Every node handed out by this pool becomes invalid.
+	*/
+	void release()
+	{
+		Slab *temp;
+		while (first_slab != NULL)
+		{
+			temp = first_slab;
+			first_slab = first_slab->next;
+			free(temp);
+		}
+		last_slab = NULL;
+		free_list = NULL;
+		free_list_tail = NULL;
+		current = NULL;
+		current_end = NULL;
+		slab_bytes = 0;
+	}
+
+	long long getAllocationCount() const
+	{
+		return allocation_count;
+	}
+
+	// Slabs are only returned on release, so the memory held now is the peak.
+	long long getPeakBytes() const
+	{
+		return slab_bytes;
+	}
+
+private:
+	static const int MIN_SLAB_SIZE = 64;
+	static const int MAX_SLAB_SIZE = 65536;
+
+	union Slot
+	{
+		Slot *next;
+		alignas(NodeType) unsigned char storage[sizeof(NodeType)];
+	};
+
+	struct Slab
+	{
+		Slab *next;
+		// The slots follow the header in the same block.
+	};
+
+	NodePool(const NodePool&);
+	NodePool& operator=(const NodePool&);
+
+	void grow()
+	{
+		size_t header = (sizeof(Slab) + alignof(Slot) - 1) / alignof(Slot) * alignof(Slot);
+		Slab *slab = (Slab *)malloc(header + sizeof(Slot) * next_slab_size);
+		if (slab == NULL)
+			throw std::bad_alloc();
+		slab_bytes += header + sizeof(Slot) * next_slab_size;
+		slab->next = NULL;
+		if (first_slab == NULL)
+			first_slab = slab;
+		else
+			last_slab->next = slab;
+		last_slab = slab;
+		current = reinterpret_cast<Slot *>(reinterpret_cast<char *>(slab) + header);
+		current_end = current + next_slab_size;
+		if (next_slab_size < MAX_SLAB_SIZE)
+			next_slab_size <<= 1;
+		allocation_count++;
+	}
+
+	Slab *first_slab, *last_slab;
+	Slot *free_list, *free_list_tail;
+	// Unused part of the most recent slab.
+	Slot *current, *current_end;
+	int next_slab_size;
+	long long allocation_count, slab_bytes;
+};
+
+#endif // #ifndef __NODE_POOL_H__
@@ -1,152 +1,122 @@
+#include <cstdio>
 #include <cstdlib>
+#include <ctime>
+#include <vector>
+#include "PairingHeap.h"
 
-template <class T> struct PairingHeapNode
-{
-	T key;
-	PairingHeapNode *leftChild, *leftSibling, *rightSibling, *parent;
-};
-
-template <class T> class PairingHeap
-{
-public:
-	PairingHeap();
-	void merge(PairingHeap<T> &);
-	PairingHeapNode<T> *insert(const T &);
-	T getMin() const;
-	T extractMin();
-	void decreaseKey(PairingHeapNode<T> *, const T &);
-	int getSize() const;
-
-private:
-	PairingHeapNode<T> *root;
-	int size;
-	PairingHeapNode<T> *merge(PairingHeapNode<T> *, PairingHeapNode<T> *);
-	PairingHeapNode<T> *merge_pairs(PairingHeapNode<T> *);
-};
-
-template <class T> PairingHeap<T>::PairingHeap()
-{
-	root = NULL;
-	size = 0;
-}
+const int NUM_ELEMENTS = 1 << 20;
+const int NUM_ROUNDS = 1 << 21;
 
-template <class T> void PairingHeap<T>::merge(PairingHeap<T> &ph)
+// Fills the heap, runs a steady insert/extract phase and drains it again.
+template <template <class> class Allocator> void benchmark(const char *name)
 {
-	root = merge(root, ph.root);
-	size += ph.size;
-	ph.root = NULL;
-	size = 0;
+	PairingHeap<int, Allocator> heap;
+	long long operations = 2LL * (NUM_ELEMENTS + NUM_ROUNDS);
+	unsigned startTime = clock();
+	int i;
+	for (i = 0; i < NUM_ELEMENTS; i++)
+		heap.insert(rand());
+	for (i = 0; i < NUM_ROUNDS; i++)
+	{
+		heap.extractMin();
+		heap.insert(rand());
+	}
+	while (heap.getSize() > 0)
+		heap.extractMin();
+	fprintf(stdout, "%s: %.3lfs, %lld allocations, %.6lf per operation\n", name,
+		(double)(clock() - startTime) / (double)CLOCKS_PER_SEC,
+		heap.getAllocationCount(), (double)heap.getAllocationCount() / (double)operations);
 }
 
-template <class T> PairingHeapNode<T> *PairingHeap<T>::insert(const T &key)
-{
-	PairingHeapNode<T> *new_root = new PairingHeapNode<T>;
-	new_root->key = key;
-	new_root->leftChild = NULL;
-	new_root->leftSibling = NULL;
-	new_root->rightSibling = NULL;
-	new_root->parent = NULL;
-	root = merge(root, new_root);
-	size++;
-	return new_root;
-}
+const int NUM_INSERTS = 1 << 20;
+const int NUM_LIVE = 1 << 16;
 
-template <class T> T PairingHeap<T>::getMin() const
+// Insert-heavy: every key is inserted before the first extraction.
+void benchmarkInsertHeavy(PairingStrategy strategy, const char *name)
 {
-	return root->key;
+	PairingHeap<int> heap(strategy);
+	unsigned startTime = clock();
+	int i;
+	for (i = 0; i < NUM_INSERTS; i++)
+		heap.insert(rand());
+	while (heap.getSize() > 0)
+		heap.extractMin();
+	fprintf(stdout, "%s, insert-heavy: %.3lfs\n", name,
+		(double)(clock() - startTime) / (double)CLOCKS_PER_SEC);
 }
 
-template <class T> T PairingHeap<T>::extractMin()
+// Alternating: a small heap with interleaved inserts and extractions.
+void benchmarkAlternating(PairingStrategy strategy, const char *name)
 {
-	T result = root->key;
-	PairingHeapNode<T> *current = root->leftChild;
-	delete root;
-	root = merge_pairs(current);
-	size--;
-	return result;
-}
-
-template <class T> void PairingHeap<T>::decreaseKey(PairingHeapNode<T> *element, const T &new_key)
-{
-	if (element->key > new_key)
+	PairingHeap<int> heap(strategy);
+	unsigned startTime = clock();
+	int i;
+	for (i = 0; i < NUM_LIVE; i++)
+		heap.insert(rand());
+	for (i = 0; i < NUM_INSERTS; i++)
 	{
-		element->key = new_key;
-		if (element != root)
-		{
-			if (element->parent == NULL)
-				element->leftSibling->rightSibling = element->rightSibling;
-			else
-			{
-				element->parent->leftChild = element->rightSibling;
-				if (element->rightSibling != NULL)
-					element->rightSibling->parent = element->parent;
-			}
-			element->leftSibling = NULL;
-			element->rightSibling = NULL;
-			element->parent = NULL;
-			root = merge(root, element);
-		}
+		heap.insert(rand());
+		heap.insert(rand());
+		heap.extractMin();
+		heap.extractMin();
 	}
+	fprintf(stdout, "%s, alternating: %.3lfs\n", name,
+		(double)(clock() - startTime) / (double)CLOCKS_PER_SEC);
 }
 
-template <class T> int PairingHeap<T>::getSize() const
-{
-	return size;
-}
+const int NUM_QUEUED = 1 << 18;
+const int NUM_DRAINED = 1 << 21;
 
-template <class T> PairingHeapNode<T> *PairingHeap<T>::merge(PairingHeapNode<T> *root1, PairingHeapNode<T> *root2)
+// Dispatcher ticks: every tick queues batch new keys and takes out the batch
+// smallest, with a loop of extractMin or with one extractMinBatch.
+template <bool use_batch> double runTicks(int batch)
 {
-	if (root1 == NULL)
-		return root2;
-	if (root2 == NULL)
-		return root1;
-	if (root1->key <= root2->key)
-	{
-		if (root1->leftChild != NULL)
-		{
-			root2->rightSibling = root1->leftChild;
-			root1->leftChild->leftSibling = root2;
-			root1->leftChild->parent = NULL;
-		}
-		root1->leftChild = root2;
-		root2->parent = root1;
-		return root1;
-	}
-	if (root2->leftChild != NULL)
+	PairingHeap<int> heap;
+	std::vector<int> out;
+	unsigned startTime;
+	int i, tick;
+	srand(42);
+	for (i = 0; i < NUM_QUEUED; i++)
+		heap.insert(rand());
+	out.reserve(batch);
+	startTime = clock();
+	for (tick = 0; tick < NUM_DRAINED / batch; tick++)
 	{
-		root1->rightSibling = root2->leftChild;
-		root2->leftChild->leftSibling = root1;
-		root2->leftChild->parent = NULL;
+		for (i = 0; i < batch; i++)
+			heap.insert(rand());
+		out.clear();
+		if (use_batch)
+			heap.extractMinBatch(batch, out);
+		else
+			for (i = 0; i < batch; i++)
+				out.push_back(heap.extractMin());
 	}
-	root2->leftChild = root1;
-	root1->parent = root2;
-	return root2;
+	return (double)(clock() - startTime) / (double)CLOCKS_PER_SEC;
 }
 
-template <class T> PairingHeapNode<T> *PairingHeap<T>::merge_pairs(PairingHeapNode<T> *root)
+void benchmarkBatch(int batch)
 {
-	PairingHeapNode<T> *next, *next_next;
-	if (root != NULL)
-	{
-		if (root->rightSibling != NULL)
-		{
-			next = root->rightSibling;
-			next_next = next->rightSibling;
-			root->leftSibling = NULL;
-			root->rightSibling = NULL;
-			root->parent = NULL;
-			next->leftSibling = NULL;
-			next->rightSibling = NULL;
-			next->parent = NULL;
-			return merge(merge(root, next), merge_pairs(next_next));
-		}
-		root->leftSibling = NULL;
-		root->parent = NULL;
-	}
-	return root;
+	double looped = runTicks<false>(batch), batched = runTicks<true>(batch);
+	fprintf(stdout, "batches of %4d: extractMin loop %.3lfs, extractMinBatch %.3lfs\n", batch, looped, batched);
 }
 
 int main()
 {
-  return 0;
-}
+	const PairingStrategy strategies[] = { TWO_PASS, MULTI_PASS, BACK_TO_FRONT };
+	const char *names[] = { "two-pass", "multi-pass", "back-to-front" };
+	int i;
+	srand(42);
+	benchmark<NewDeleteAllocator>("new/delete");
+	srand(42);
+	benchmark<NodePool>("node pool");
+	for (i = 0; i < 3; i++)
+	{
+		srand(42);
+		benchmarkInsertHeavy(strategies[i], names[i]);
+		srand(42);
+		benchmarkAlternating(strategies[i], names[i]);
+	}
+	for (i = 64; i <= 1024; i <<= 2)
+		benchmarkBatch(i);
+	return 0;
+}
\ No newline at end of file
@@ -0,0 +1,445 @@
+#ifndef __PAIRING_HEAP_H__
+#define __PAIRING_HEAP_H__
+
+#include <cstdlib>
+#include <algorithm>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "NodePool.h"
+
+template <class T> struct PairingHeapNode
+{
+	T key;
+	PairingHeapNode *leftChild, *leftSibling, *rightSibling, *parent;
+
+	// The key is constructed in place from args.
+	template <class... Args> explicit PairingHeapNode(Args&&... args)
+		: key(std::forward<Args>(args)...)
+	{
+		leftChild = NULL;
+		leftSibling = NULL;
+		rightSibling = NULL;
+		parent = NULL;
+	}
+};
+
+// Order in which extractMin links the children of the removed root.
+enum PairingStrategy
+{
+	// Link neighbouring pairs left to right, then link the pairs right to left.
+	TWO_PASS,
+	// Link neighbouring pairs left to right until a single tree is left.
+	MULTI_PASS,
+	// Link neighbouring pairs right to left, then link the pairs left to right.
+	BACK_TO_FRONT
+};
+
+template <class T, template <class> class Allocator = NodePool> class PairingHeap
+{
+public:
+	PairingHeap(PairingStrategy = TWO_PASS);
+	~PairingHeap();
+	void merge(PairingHeap<T, Allocator> &);
+	PairingHeapNode<T> *insert(const T &);
+	PairingHeapNode<T> *insert(T &&);
+	// Constructs the key in place from args.
+	template <class... Args> PairingHeapNode<T> *emplace(Args&&...);
+	const T &getMin() const;
+	// The key is moved out of the heap, not copied.
+	T extractMin();
+	// Appends the (at most) k smallest keys to out in increasing order and
+	// returns their number. The remaining trees are paired once for the batch.
+	int extractMinBatch(int k, std::vector<T> &out);
+	// Moves all keys to the end of out in no particular order and empties the
+	// heap in O(n).
+	void extractAll(std::vector<T> &out);
+	void decreaseKey(PairingHeapNode<T> *, const T &);
+	// For T = Prioritized<Priority, Payload>: decreases only the priority and
+	// leaves the payload where it is.
+	template <class Priority> void decreasePriority(PairingHeapNode<T> *, const Priority &);
+	// The node is taken out with its children paired, then merged back alone.
+	void increaseKey(PairingHeapNode<T> *, const T &);
+	template <class Priority> void increasePriority(PairingHeapNode<T> *, const Priority &);
+	// Removes any element of the heap; the handle becomes invalid.
+	void erase(PairingHeapNode<T> *);
+	int getSize() const;
+	long long getAllocationCount() const;
+	long long getPeakNodeMemory() const;
+
+private:
+	PairingHeapNode<T> *root;
+	int size;
+	Allocator<PairingHeapNode<T> > allocator;
+	PairingStrategy strategy;
+	// Reused by merge_pairs so that extractMin needs neither recursion nor
+	// allocation once the buffer has grown to the widest child list.
+	// extractMinBatch keeps it as a binary heap of candidate roots, and
+	// the roots that cannot be among the smallest in batch_rest.
+	std::vector<PairingHeapNode<T> *> scratch, batch_rest;
+	struct larger_key
+	{
+		bool operator()(const PairingHeapNode<T> *x, const PairingHeapNode<T> *y) const
+		{
+			return x->key > y->key;
+		}
+	};
+	PairingHeap(const PairingHeap &);
+	PairingHeap &operator=(const PairingHeap &);
+	void delete_nodes();
+	PairingHeapNode<T> *merge(PairingHeapNode<T> *, PairingHeapNode<T> *);
+	PairingHeapNode<T> *merge_pairs(PairingHeapNode<T> *);
+	PairingHeapNode<T> *merge_scratch();
+	void key_decreased(PairingHeapNode<T> *);
+	void key_increased(PairingHeapNode<T> *);
+	void detach(PairingHeapNode<T> *);
+};
+
+template <class T, template <class> class Allocator> PairingHeap<T, Allocator>::PairingHeap(PairingStrategy pairing_strategy)
+{
+	root = NULL;
+	size = 0;
+	strategy = pairing_strategy;
+}
+
+template <class T, template <class> class Allocator> PairingHeap<T, Allocator>::~PairingHeap()
+{
+	if (!Allocator<PairingHeapNode<T> >::releases_in_bulk || !std::is_trivially_destructible<T>::value)
+		delete_nodes();
+}
+
+template <class T, template <class> class Allocator> void PairingHeap<T, Allocator>::delete_nodes()
+{
+	PairingHeapNode<T> *current = root, *temp;
+	// Rotates children up into the sibling chain, so no recursion is needed.
+	while (current != NULL)
+	{
+		if (current->leftChild != NULL)
+		{
+			temp = current->leftChild;
+			current->leftChild = temp->rightSibling;
+			temp->rightSibling = current;
+			current = temp;
+		}
+		else
+		{
+			temp = current->rightSibling;
+			allocator.deallocate(current);
+			current = temp;
+		}
+	}
+	root = NULL;
+	size = 0;
+}
+
+template <class T, template <class> class Allocator> void PairingHeap<T, Allocator>::merge(PairingHeap<T, Allocator> &ph)
+{
+	root = merge(root, ph.root);
+	size += ph.size;
+	allocator.adopt(ph.allocator);
+	ph.root = NULL;
+	ph.size = 0;
+}
+
+template <class T, template <class> class Allocator> PairingHeapNode<T> *PairingHeap<T, Allocator>::insert(const T &key)
+{
+	return emplace(key);
+}
+
+template <class T, template <class> class Allocator> PairingHeapNode<T> *PairingHeap<T, Allocator>::insert(T &&key)
+{
+	return emplace(std::move(key));
+}
+
+template <class T, template <class> class Allocator> template <class... Args>
+PairingHeapNode<T> *PairingHeap<T, Allocator>::emplace(Args&&... args)
+{
+	PairingHeapNode<T> *new_root = allocator.allocate(std::forward<Args>(args)...);
+	root = merge(root, new_root);
+	size++;
+	return new_root;
+}
+
+template <class T, template <class> class Allocator> const T &PairingHeap<T, Allocator>::getMin() const
+{
+	return root->key;
+}
+
+template <class T, template <class> class Allocator> T PairingHeap<T, Allocator>::extractMin()
+{
+	T result = std::move(root->key);
+	PairingHeapNode<T> *current = root->leftChild;
+	allocator.deallocate(root);
+	root = merge_pairs(current);
+	size--;
+	return result;
+}
+
+template <class T, template <class> class Allocator> int PairingHeap<T, Allocator>::extractMinBatch(int k, std::vector<T> &out)
+{
+	PairingHeapNode<T> *current, *child;
+	int i, j, roots, needed;
+	if (k > size)
+		k = size;
+	if (k <= 0)
+		return 0;
+	// Every extracted node is the smallest of the candidate roots; its
+	// children become candidates in turn. Only the roots that can still be
+	// among the k smallest are kept in the binary heap of candidates; the
+	// others wait in batch_rest, and all trees are paired once at the end.
+	scratch.clear();
+	batch_rest.clear();
+	scratch.push_back(root);
+	for (i = 0; i < k; i++)
+	{
+		std::pop_heap(scratch.begin(), scratch.end(), larger_key());
+		current = scratch.back();
+		scratch.pop_back();
+		out.push_back(std::move(current->key));
+		roots = scratch.size();
+		for (child = current->leftChild; child != NULL; child = child->rightSibling)
+			scratch.push_back(child);
+		allocator.deallocate(current);
+		needed = k - i - 1;
+		if ((int)scratch.size() > 2 * needed)
+		{
+			// A long child list (the root usually has one child per insert
+			// since the last pairing) is cut down to the needed smallest
+			// roots in linear time.
+			std::nth_element(scratch.begin(), scratch.end() - needed, scratch.end(), larger_key());
+			batch_rest.insert(batch_rest.end(), scratch.begin(), scratch.end() - needed);
+			scratch.erase(scratch.begin(), scratch.end() - needed);
+			std::make_heap(scratch.begin(), scratch.end(), larger_key());
+		}
+		else
+			for (j = roots + 1; j <= (int)scratch.size(); j++)
+				std::push_heap(scratch.begin(), scratch.begin() + j, larger_key());
+	}
+	size -= k;
+	scratch.insert(scratch.end(), batch_rest.begin(), batch_rest.end());
+	root = scratch.empty() ? NULL : merge_scratch();
+	return k;
+}
+
+template <class T, template <class> class Allocator> void PairingHeap<T, Allocator>::extractAll(std::vector<T> &out)
+{
+	PairingHeapNode<T> *current = root, *temp;
+	// The same walk as delete_nodes.
+	while (current != NULL)
+	{
+		if (current->leftChild != NULL)
+		{
+			temp = current->leftChild;
+			current->leftChild = temp->rightSibling;
+			temp->rightSibling = current;
+			current = temp;
+		}
+		else
+		{
+			temp = current->rightSibling;
+			out.push_back(std::move(current->key));
+			allocator.deallocate(current);
+			current = temp;
+		}
+	}
+	root = NULL;
+	size = 0;
+}
+
+template <class T, template <class> class Allocator> void PairingHeap<T, Allocator>::decreaseKey(PairingHeapNode<T> *element, const T &new_key)
+{
+	if (element->key > new_key)
+	{
+		element->key = new_key;
+		key_decreased(element);
+	}
+}
+
+template <class T, template <class> class Allocator> template <class Priority>
+void PairingHeap<T, Allocator>::decreasePriority(PairingHeapNode<T> *element, const Priority &new_priority)
+{
+	if (new_priority < element->key.priority)
+	{
+		element->key.priority = new_priority;
+		key_decreased(element);
+	}
+}
+
+template <class T, template <class> class Allocator> void PairingHeap<T, Allocator>::key_decreased(PairingHeapNode<T> *element)
+{
+	if (element != root)
+	{
+		detach(element);
+		root = merge(root, element);
+	}
+}
+
+template <class T, template <class> class Allocator> void PairingHeap<T, Allocator>::increaseKey(PairingHeapNode<T> *element, const T &new_key)
+{
+	if (new_key > element->key)
+	{
+		element->key = new_key;
+		key_increased(element);
+	}
+}
+
+template <class T, template <class> class Allocator> template <class Priority>
+void PairingHeap<T, Allocator>::increasePriority(PairingHeapNode<T> *element, const Priority &new_priority)
+{
+	if (element->key.priority < new_priority)
+	{
+		element->key.priority = new_priority;
+		key_increased(element);
+	}
+}
+
+template <class T, template <class> class Allocator> void PairingHeap<T, Allocator>::key_increased(PairingHeapNode<T> *element)
+{
+	PairingHeapNode<T> *children = element->leftChild;
+	// The children may now be smaller than the node, so they are paired into
+	// a tree of their own and the node goes back into the heap on its own.
+	element->leftChild = NULL;
+	if (element == root)
+		root = merge_pairs(children);
+	else
+	{
+		detach(element);
+		root = merge(root, merge_pairs(children));
+	}
+	root = merge(root, element);
+}
+
+template <class T, template <class> class Allocator> void PairingHeap<T, Allocator>::erase(PairingHeapNode<T> *element)
+{
+	if (element == root)
+		root = merge_pairs(element->leftChild);
+	else
+	{
+		detach(element);
+		root = merge(root, merge_pairs(element->leftChild));
+	}
+	allocator.deallocate(element);
+	size--;
+}
+
+// Unlinks a node other than the root from its parent and siblings.
+template <class T, template <class> class Allocator> void PairingHeap<T, Allocator>::detach(PairingHeapNode<T> *element)
+{
+	// Only the leftmost child keeps a parent pointer; the others are
+	// reached through their left sibling.
+	if (element->parent == NULL)
+	{
+		element->leftSibling->rightSibling = element->rightSibling;
+		if (element->rightSibling != NULL)
+			element->rightSibling->leftSibling = element->leftSibling;
+	}
+	else
+	{
+		element->parent->leftChild = element->rightSibling;
+		if (element->rightSibling != NULL)
+			element->rightSibling->parent = element->parent;
+	}
+	element->leftSibling = NULL;
+	element->rightSibling = NULL;
+	element->parent = NULL;
+}
+
+template <class T, template <class> class Allocator> int PairingHeap<T, Allocator>::getSize() const
+{
+	return size;
+}
+
+template <class T, template <class> class Allocator> long long PairingHeap<T, Allocator>::getAllocationCount() const
+{
+	return allocator.getAllocationCount();
+}
+
+template <class T, template <class> class Allocator> long long PairingHeap<T, Allocator>::getPeakNodeMemory() const
+{
+	return allocator.getPeakBytes();
+}
+
+template <class T, template <class> class Allocator> PairingHeapNode<T> *PairingHeap<T, Allocator>::merge(PairingHeapNode<T> *root1, PairingHeapNode<T> *root2)
+{
+	if (root1 == NULL)
+		return root2;
+	if (root2 == NULL)
+		return root1;
+	if (root1->key <= root2->key)
+	{
+		if (root1->leftChild != NULL)
+		{
+			root2->rightSibling = root1->leftChild;
+			root1->leftChild->leftSibling = root2;
+			root1->leftChild->parent = NULL;
+		}
+		root1->leftChild = root2;
+		root2->parent = root1;
+		return root1;
+	}
+	if (root2->leftChild != NULL)
+	{
+		root1->rightSibling = root2->leftChild;
+		root2->leftChild->leftSibling = root1;
+		root2->leftChild->parent = NULL;
+	}
+	root2->leftChild = root1;
+	root1->parent = root2;
+	return root2;
+}
+
+template <class T, template <class> class Allocator> PairingHeapNode<T> *PairingHeap<T, Allocator>::merge_pairs(PairingHeapNode<T> *first)
+{
+	if (first == NULL)
+		return NULL;
+	scratch.clear();
+	for (; first != NULL; first = first->rightSibling)
+		scratch.push_back(first);
+	return merge_scratch();
+}
+
+// Links the trees in scratch (at least one) into one according to strategy.
+template <class T, template <class> class Allocator> PairingHeapNode<T> *PairingHeap<T, Allocator>::merge_scratch()
+{
+	PairingHeapNode<T> *result;
+	int count = scratch.size(), i, j;
+	for (i = 0; i < count; i++)
+	{
+		scratch[i]->leftSibling = NULL;
+		scratch[i]->rightSibling = NULL;
+		scratch[i]->parent = NULL;
+	}
+	if (strategy == MULTI_PASS)
+	{
+		while (count > 1)
+		{
+			for (i = 0, j = 0; i + 1 < count; i += 2)
+				scratch[j++] = merge(scratch[i], scratch[i + 1]);
+			if (i < count)
+				scratch[j++] = scratch[i];
+			count = j;
+		}
+		return scratch[0];
+	}
+	if (strategy == BACK_TO_FRONT)
+	{
+		for (i = count - 1, j = count; i > 0; i -= 2)
+			scratch[--j] = merge(scratch[i - 1], scratch[i]);
+		if (i == 0)
+			scratch[--j] = scratch[0];
+		result = scratch[j];
+		for (i = j + 1; i < count; i++)
+			result = merge(result, scratch[i]);
+		return result;
+	}
+	for (i = 0, j = 0; i + 1 < count; i += 2)
+		scratch[j++] = merge(scratch[i], scratch[i + 1]);
+	if (i < count)
+		scratch[j++] = scratch[i];
+	result = scratch[j - 1];
+	for (i = j - 2; i >= 0; i--)
+		result = merge(scratch[i], result);
+	return result;
+}
+
+#endif // #ifndef __PAIRING_HEAP_H__
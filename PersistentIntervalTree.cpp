@@ -0,0 +1,277 @@
+/**
+* Persistent Interval Tree implementation in C++
+* @keywords: Data Structures, Dynamic RMQ, Persistence
+*
+* The interval update and query of IntervalTree, where every update creates a
+* new version and the maximum of an interval can be queried in any version.
+*
+* An update copies only the nodes it touches (path copying), at most four per
+* level, and the versions share all other nodes. The adds stored in the nodes
+* are never pushed down, as that would change nodes shared with older
+* versions; a query adds the adds of the nodes on its way instead. Versions
+* are never freed, and the nodes come from a NodePool that is released when
+* the tree is destroyed.
+*/
+
+#ifndef __PERSISTENT_INTERVAL_TREE_H__
+#define __PERSISTENT_INTERVAL_TREE_H__
+
+#include <algorithm>
+#include <cassert>
+#include <vector>
+#include "NodePool.h"
+using namespace std;
+
+template <typename T> class PersistentIntervalTree {
+public:
+
+	/**
+	* Creates version 0 with initial values given in values.
+	* Each update and query should allow indices [0, values.size() - 1].
+	*/
+	PersistentIntervalTree(const vector<T>& values) {
+		interval_size = values.size();
+		node_count = 0;
+		height = 0;
+		while ((1 << height) < interval_size)
+			height++;
+		roots.push_back(build(values, 0, interval_size - 1));
+	}
+
+	/**
+	* Adds the value add to each element in the interval [idx1, idx2] of the
+	* latest version, and returns the number of the new version.
+	*/
+	int update(int idx1, int idx2, const T &add) {
+		long long before = node_count;
+		roots.push_back(update(roots.back(), 0, interval_size - 1, idx1, idx2, add));
+		assert((node_count - before) * (long long)sizeof(Node) <= getUpdateBudget());
+		return roots.size() - 1;
+	}
+
+	/**
+	* Returns the maximum value in the interval [idx1, idx2] of version.
+	*/
+	T query(int version, int idx1, int idx2) const {
+		return query(roots[version], 0, interval_size - 1, idx1, idx2);
+	}
+
+	// The number of the latest version.
+	int getVersion() const {
+		return roots.size() - 1;
+	}
+
+	/**
+	* The most node memory an update may take: one node for each of the two
+	* borders and for each of the two nodes covered next to them, per level.
+	* update asserts that it stays within it.
+	*/
+	long long getUpdateBudget() const {
+		return (4LL * height + 1) * sizeof(Node);
+	}
+
+	long long getNodeCount() const {
+		return node_count;
+	}
+
+	long long getPeakNodeMemory() const {
+		return allocator.getPeakBytes();
+	}
+
+private:
+
+	struct Node {
+		// The maximum of the subtree including add, but not the adds of the
+		// ancestors.
+		T value, add;
+		const Node *left, *right;
+
+		Node(const T &value) : value(value), add(), left(NULL), right(NULL) {
+		}
+	};
+
+	PersistentIntervalTree(const PersistentIntervalTree &);
+	PersistentIntervalTree &operator=(const PersistentIntervalTree &);
+
+	const Node *build(const vector<T> &values, int begin, int end) {
+		Node *node;
+		int mid;
+		if (begin == end) {
+			node_count++;
+			return allocator.allocate(values[begin]);
+		}
+		mid = (begin + end) >> 1;
+		const Node *left = build(values, begin, mid);
+		const Node *right = build(values, mid + 1, end);
+		node = allocator.allocate(max(left->value, right->value));
+		node_count++;
+		node->left = left;
+		node->right = right;
+		return node;
+	}
+
+	const Node *update(const Node *node, int begin, int end, int idx1, int idx2, const T &add) {
+		Node *copy = allocator.allocate(*node);
+		int mid;
+		node_count++;
+		if (idx1 <= begin && end <= idx2) {
+			copy->value += add;
+			copy->add += add;
+			return copy;
+		}
+		mid = (begin + end) >> 1;
+		if (idx1 <= mid)
+			copy->left = update(node->left, begin, mid, idx1, idx2, add);
+		if (idx2 > mid)
+			copy->right = update(node->right, mid + 1, end, idx1, idx2, add);
+		copy->value = max(copy->left->value, copy->right->value) + copy->add;
+		return copy;
+	}
+
+	T query(const Node *node, int begin, int end, int idx1, int idx2) const {
+		int mid;
+		if (idx1 <= begin && end <= idx2)
+			return node->value;
+		mid = (begin + end) >> 1;
+		if (idx2 <= mid)
+			return query(node->left, begin, mid, idx1, idx2) + node->add;
+		if (idx1 > mid)
+			return query(node->right, mid + 1, end, idx1, idx2) + node->add;
+		return max(query(node->left, begin, mid, idx1, idx2),
+			query(node->right, mid + 1, end, idx1, idx2)) + node->add;
+	}
+
+	// The root of every version.
+	vector<const Node *> roots;
+	int interval_size, height;
+	long long node_count;
+	NodePool<Node> allocator;
+};
+
+#endif // #ifndef __PERSISTENT_INTERVAL_TREE_H__
+
+
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+
+const int MAX_IDX = 65536;
+const int NUM_UPDATES = 1 << 18;
+const int NUM_QUERIES = 1 << 20;
+// Queries of random versions, each answered by rebuilding that version.
+const int NUM_REBUILDS = 1024;
+
+struct Update {
+	int x1, x2;
+	int val;
+};
+
+int init[MAX_IDX];
+Update updates[NUM_UPDATES];
+
+unsigned state = 42;
+
+int rand30() {
+	state = state * 1103515245 + 12345;
+	return state >> 2;
+}
+
+void randomInterval(int &x1, int &x2) {
+	x1 = rand30() % MAX_IDX;
+	x2 = rand30() % MAX_IDX;
+	if (x1 > x2)
+		swap(x1, x2);
+}
+
+// The previous way to query old versions: the values of the version are
+// computed from the updates up to it, and a static maximum tree is built over
+// them.
+class RebuiltVersion {
+public:
+
+	RebuiltVersion(int version) : tree(MAX_IDX << 1) {
+		vector<long long> changes(MAX_IDX + 1, 0);
+		long long add = 0;
+		int i;
+		for (i = 0; i < version; i++) {
+			changes[updates[i].x1] += updates[i].val;
+			changes[updates[i].x2 + 1] -= updates[i].val;
+		}
+		for (i = 0; i < MAX_IDX; i++) {
+			add += changes[i];
+			tree[MAX_IDX + i] = init[i] + add;
+		}
+		for (i = MAX_IDX - 1; i > 0; i--)
+			tree[i] = max(tree[i << 1], tree[(i << 1) + 1]);
+	}
+
+	long long query(int x1, int x2) const {
+		long long result = tree[x1 + MAX_IDX];
+		for (x1 += MAX_IDX, x2 += MAX_IDX + 1; x1 < x2; x1 >>= 1, x2 >>= 1) {
+			if (x1 & 1)
+				result = max(result, tree[x1++]);
+			if (x2 & 1)
+				result = max(result, tree[--x2]);
+		}
+		return result;
+	}
+
+private:
+	vector<long long> tree;
+};
+
+int main(void) {
+	int i, x1, x2;
+	long long checksum = 0;
+	bool correct = true;
+
+	for (i = 0; i < MAX_IDX; i++)
+		init[i] = rand30() % 2000001 - 1000000;
+	for (i = 0; i < NUM_UPDATES; i++) {
+		randomInterval(updates[i].x1, updates[i].x2);
+		updates[i].val = rand30() % 20001 - 10000;
+	}
+
+	PersistentIntervalTree<long long> tree(vector<long long>(init, init + MAX_IDX));
+	long long initial_nodes = tree.getNodeCount();
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for (i = 0; i < NUM_UPDATES; i++)
+		tree.update(updates[i].x1, updates[i].x2, updates[i].val);
+	double update_elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	start = chrono::steady_clock::now();
+	for (i = 0; i < NUM_QUERIES; i++) {
+		randomInterval(x1, x2);
+		checksum += tree.query(rand30() % (NUM_UPDATES + 1), x1, x2);
+	}
+	double query_elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	fprintf(stdout, "%d updates: %.3lfs (%.2lf Mops/s), %d queries of random versions: %.3lfs (%.2lf Mops/s), checksum %lld\n",
+		NUM_UPDATES, update_elapsed, NUM_UPDATES / update_elapsed / 1e6,
+		NUM_QUERIES, query_elapsed, NUM_QUERIES / query_elapsed / 1e6, checksum);
+	fprintf(stdout, "%.1lf nodes (%.0lf bytes) per update, budget %lld bytes; %.1lf MB of nodes in total\n",
+		(double)(tree.getNodeCount() - initial_nodes) / NUM_UPDATES,
+		(double)(tree.getNodeCount() - initial_nodes) / NUM_UPDATES * tree.getPeakNodeMemory() / tree.getNodeCount(),
+		tree.getUpdateBudget(), tree.getPeakNodeMemory() / 1048576.0);
+
+	vector<long long> persistent(NUM_REBUILDS), rebuilt(NUM_REBUILDS);
+	vector<int> versions(NUM_REBUILDS), intervals(NUM_REBUILDS << 1);
+	for (i = 0; i < NUM_REBUILDS; i++) {
+		versions[i] = rand30() % (NUM_UPDATES + 1);
+		randomInterval(intervals[i << 1], intervals[(i << 1) + 1]);
+	}
+	start = chrono::steady_clock::now();
+	for (i = 0; i < NUM_REBUILDS; i++)
+		persistent[i] = tree.query(versions[i], intervals[i << 1], intervals[(i << 1) + 1]);
+	double persistent_elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	start = chrono::steady_clock::now();
+	for (i = 0; i < NUM_REBUILDS; i++) {
+		RebuiltVersion version(versions[i]);
+		rebuilt[i] = version.query(intervals[i << 1], intervals[(i << 1) + 1]);
+	}
+	double rebuilt_elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	for (i = 0; i < NUM_REBUILDS; i++)
+		if (persistent[i] != rebuilt[i])
+			correct = false;
+	fprintf(stdout, "%d queries of random versions: persistent %.6lfs, rebuild per version %.3lfs, %s\n",
+		NUM_REBUILDS, persistent_elapsed, rebuilt_elapsed, correct ? "correct" : "incorect");
+	return 0;
+}
@@ -1,187 +1,508 @@
 #include <type_traits>
+#include <utility>
 #include <cstdlib>
+#include <cstdio>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+#include <sys/resource.h>
+#include "NodePool.h"
+
+/*
+* The elements are kept in leaves of 32 values. All leaves but the last are in
+* a trie of nodes with 32 children each; the last one is the tail and is kept
+* outside the trie, so most operations at the end of the vector do not touch
+* the trie at all.
+*
+* Versions share leaves and nodes. Every leaf and node remembers how many of
+* its slots have been written by any version (filled). A version may write
+* the next slot in place if no other version has written it yet, which is
+* safe because versions never look at slots past their own size. This is
+* what makes append O(1) without copying in the common case.
+*
+* A TransientVector is a vector that changes in place. Leaves and nodes
+* remember the transient vector that created them (owner); those are only
+* reachable from that transient vector, so it may change them in place, and
+* all others are copied the first time they are changed.
+*
+* Leaves and nodes count the versions and nodes that point to them, and go
+* back to a node pool when the count drops to zero. A node holds its children
+* in all filled slots, including those only other versions look at. The
+* counts and the claiming of slots are atomic, so versions can be read,
+* changed and dropped from several threads; a TransientVector can only be
+* used by one thread.
+*/
+
+template<typename T>
+struct Leaf
+{
+    std::atomic<int> references;
+    std::atomic<int> filled;
+    // The transient vector that may change the leaf in place, 0 for none.
+    unsigned long long owner;
+    T values[32];
+
+    Leaf(unsigned long long owner) : references(1), filled(0), owner(owner)
+    {
+    }
+};
 
 template<typename T>
 struct Node
 {
-    T value;
-    Node *succ[32];
-    
-    Node()
+    std::atomic<int> references;
+    std::atomic<int> filled;
+    unsigned long long owner;
+    // Nodes just above the leaves point to leaves, all others to nodes.
+    union
+    {
+        Node *nodes[32];
+        Leaf<T> *leaves[32];
+    };
+
+    Node(unsigned long long owner) : references(1), filled(0), owner(owner)
     {
-        int i;
-        for(i = 0; i < 32; i++)
-            succ[i] = NULL;
     }
 };
 
+template<typename T>
+class TransientVector;
+
 template<typename T>
 class PersistentVector {
     static_assert(std::is_scalar<T>::value,
         "PersistentVector can only be used with primitive types. Instantiate with a pointer type for"
         "something more complicated.");
-    
+
 public:
     PersistentVector();
-    
+
+    PersistentVector(const PersistentVector &);
+
+    PersistentVector(PersistentVector &&);
+
+    PersistentVector &operator=(const PersistentVector &);
+
+    PersistentVector &operator=(PersistentVector &&);
+
+    ~PersistentVector();
+
     // Returns the value of the element at position *index*.
     T operator[](int index) const;
-    
+
     // Returns a new vector with the element at position *index* replaced by *value*.
     PersistentVector update(int index, T value) const;
-    
+
     // Returns a new vector with *value* appended at the end.
     PersistentVector append(T value) const;
-    
+
     // Returns a new vector that's the same as this one but without the last element.
     PersistentVector pop() const;
-    
+
     int size() const;
-    
+
+    // The memory taken by the node pools of all vectors of T. Freed leaves and
+    // nodes are kept there for reuse, so this never decreases.
+    static long long pool_bytes();
+
 private:
+    friend class TransientVector<T>;
+
+    struct Pools
+    {
+        std::mutex mutex;
+        NodePool<Leaf<T> > leaves;
+        NodePool<Node<T> > nodes;
+    };
+
+    // The trie of the full leaves, NULL if there are none.
     Node<T> *root;
-    
+
+    Leaf<T> *tail;
+
     int elements_count;
-    
+
+    // The number of levels of nodes in the trie.
     int depth;
-    
-    T find(int, const Node<T> *, int) const;
-    
-    void update(int, const T &, Node<T> *, Node<T> *&, int) const;
-    
-    void append(const T &, Node<T> *, Node<T> *&, int) const;
-    
-    void pop(Node<T> *, Node<T> *&, int) const;
+
+    // Takes over the references of *root* and *tail*.
+    PersistentVector(Node<T> *root, Leaf<T> *tail, int elements_count, int depth);
+
+    int tail_offset() const;
+
+    Node<T> *new_path(Leaf<T> *, int, unsigned long long) const;
+
+    Node<T> *push_leaf(Node<T> *, Leaf<T> *, int, int) const;
+
+    Node<T> *update(int, const T &, const Node<T> *, int) const;
+
+    int visible_slots(int, int) const;
+
+    static Pools &pools();
+
+    static Leaf<T> *new_leaf(unsigned long long);
+
+    static Node<T> *new_node(unsigned long long);
+
+    static Leaf<T> *copy_leaf(const Leaf<T> *, int, unsigned long long);
+
+    static Node<T> *copy_node(const Node<T> *, int, int, unsigned long long);
+
+    template<typename Block>
+    static Block *acquire(Block *);
+
+    static void release(Leaf<T> *);
+
+    static void release(Node<T> *, int);
 };
 
 template<typename T>
 PersistentVector<T>::PersistentVector()
 {
+    root = NULL;
+    tail = NULL;
     elements_count = 0;
     depth = 0;
 }
 
+template<typename T>
+PersistentVector<T>::PersistentVector(Node<T> *root, Leaf<T> *tail, int elements_count, int depth)
+{
+    this->root = root;
+    this->tail = tail;
+    this->elements_count = elements_count;
+    this->depth = depth;
+}
+
+template<typename T>
+PersistentVector<T>::PersistentVector(const PersistentVector &other)
+{
+    root = acquire(other.root);
+    tail = acquire(other.tail);
+    elements_count = other.elements_count;
+    depth = other.depth;
+}
+
+template<typename T>
+PersistentVector<T>::PersistentVector(PersistentVector &&other)
+{
+    root = other.root;
+    tail = other.tail;
+    elements_count = other.elements_count;
+    depth = other.depth;
+    other.root = NULL;
+    other.tail = NULL;
+}
+
+template<typename T>
+PersistentVector<T> &PersistentVector<T>::operator=(const PersistentVector &other)
+{
+    acquire(other.root);
+    acquire(other.tail);
+    release(root, depth);
+    release(tail);
+    root = other.root;
+    tail = other.tail;
+    elements_count = other.elements_count;
+    depth = other.depth;
+    return *this;
+}
+
+// Swaps, so *other* releases the old leaves and nodes of this vector.
+template<typename T>
+PersistentVector<T> &PersistentVector<T>::operator=(PersistentVector &&other)
+{
+    std::swap(root, other.root);
+    std::swap(tail, other.tail);
+    std::swap(elements_count, other.elements_count);
+    std::swap(depth, other.depth);
+    return *this;
+}
+
+template<typename T>
+PersistentVector<T>::~PersistentVector()
+{
+    release(root, depth);
+    release(tail);
+}
+
+// Never destroyed, as vectors may outlive any static object.
+template<typename T>
+typename PersistentVector<T>::Pools &PersistentVector<T>::pools()
+{
+    static Pools *pools = new Pools;
+    return *pools;
+}
+
+template<typename T>
+long long PersistentVector<T>::pool_bytes()
+{
+    std::lock_guard<std::mutex> lock(pools().mutex);
+    return pools().leaves.getPeakBytes() + pools().nodes.getPeakBytes();
+}
+
+template<typename T>
+Leaf<T> *PersistentVector<T>::new_leaf(unsigned long long owner)
+{
+    std::lock_guard<std::mutex> lock(pools().mutex);
+    return pools().leaves.allocate(owner);
+}
+
+template<typename T>
+Node<T> *PersistentVector<T>::new_node(unsigned long long owner)
+{
+    std::lock_guard<std::mutex> lock(pools().mutex);
+    return pools().nodes.allocate(owner);
+}
+
+// A new leaf with the first *count* values of *leaf*.
+template<typename T>
+Leaf<T> *PersistentVector<T>::copy_leaf(const Leaf<T> *leaf, int count, unsigned long long owner)
+{
+    Leaf<T> *copy = new_leaf(owner);
+    int i;
+    for(i = 0; i < count; i++)
+        copy->values[i] = leaf->values[i];
+    copy->filled.store(count, std::memory_order_relaxed);
+    return copy;
+}
+
+// A new node with the first *count* children of *node*, which is at *level*.
+template<typename T>
+Node<T> *PersistentVector<T>::copy_node(const Node<T> *node, int count, int level, unsigned long long owner)
+{
+    Node<T> *copy = new_node(owner);
+    int i;
+    for(i = 0; i < count; i++)
+        if(level == 1)
+            copy->leaves[i] = acquire(node->leaves[i]);
+        else
+            copy->nodes[i] = acquire(node->nodes[i]);
+    copy->filled.store(count, std::memory_order_relaxed);
+    return copy;
+}
+
+template<typename T>
+template<typename Block>
+Block *PersistentVector<T>::acquire(Block *block)
+{
+    if(block != NULL)
+        block->references.fetch_add(1, std::memory_order_relaxed);
+    return block;
+}
+
+template<typename T>
+void PersistentVector<T>::release(Leaf<T> *leaf)
+{
+    if(leaf == NULL || leaf->references.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        return;
+    std::lock_guard<std::mutex> lock(pools().mutex);
+    pools().leaves.deallocate(leaf);
+}
+
+// Releases *node*, which is at *level*, and its children if it's freed.
+template<typename T>
+void PersistentVector<T>::release(Node<T> *node, int level)
+{
+    int i, count;
+    if(node == NULL || node->references.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        return;
+    count = node->filled;
+    for(i = 0; i < count; i++)
+        if(level == 1)
+            release(node->leaves[i]);
+        else
+            release(node->nodes[i], level - 1);
+    std::lock_guard<std::mutex> lock(pools().mutex);
+    pools().nodes.deallocate(node);
+}
+
+// The index of the first element in the tail.
+template<typename T>
+int PersistentVector<T>::tail_offset() const
+{
+    if(elements_count == 0)
+        return 0;
+    return (elements_count - 1) >> 5 << 5;
+}
+
 template<typename T>
 T PersistentVector<T>::operator[](int index) const
 {
-    return find(index, root, depth);
+    const Node<T> *node = root;
+    int level;
+    if(index >= tail_offset())
+        return tail->values[index & 31];
+    for(level = depth; level > 1; level--)
+        node = node->nodes[(index >> 5 * level) & 31];
+    return node->leaves[(index >> 5) & 31]->values[index & 31];
 }
 
+// The number of slots of the node at *level* on the path to *index* that
+// this version uses: all 32, unless the node is on the right edge of the trie.
 template<typename T>
-T PersistentVector<T>::find(int index, const Node<T> *root, int level) const
+int PersistentVector<T>::visible_slots(int index, int level) const
 {
-    if(level == 0)
-        return root->value;
-    return find(index, root->succ[(index >> 5 * (level - 1)) & 31], level - 1);
+    int last = (tail_offset() >> 5) - 1;
+    if((index >> 5) >> 5 * level != last >> 5 * level)
+        return 32;
+    return ((last >> 5 * (level - 1)) & 31) + 1;
 }
 
 template<typename T>
 PersistentVector<T> PersistentVector<T>::update(int index, T value) const
 {
-    PersistentVector result;
-    update(index, value, root, result.root, depth);
-    result.elements_count = elements_count;
-    result.depth = depth;
-    return result;
+    Leaf<T> *leaf;
+    if(index >= tail_offset())
+    {
+        leaf = copy_leaf(tail, elements_count - tail_offset(), 0);
+        leaf->values[index & 31] = value;
+        return PersistentVector(acquire(root), leaf, elements_count, depth);
+    }
+    return PersistentVector(update(index, value, root, depth), acquire(tail), elements_count, depth);
 }
 
 template<typename T>
-void PersistentVector<T>::update(int index, const T &value, Node<T> *old_root, Node<T> *&new_root, int level) const
+Node<T> *PersistentVector<T>::update(int index, const T &value, const Node<T> *old_root, int level) const
 {
-    int pos, i;
-    new_root = new Node<T>;
-    if(level == 0)
-        new_root->value = value;
+    Node<T> *new_root = copy_node(old_root, visible_slots(index, level), level, 0);
+    Leaf<T> *leaf;
+    int pos = (index >> 5 * level) & 31;
+    if(level > 1)
+    {
+        release(new_root->nodes[pos], level - 1);
+        new_root->nodes[pos] = update(index, value, old_root->nodes[pos], level - 1);
+    }
     else
     {
-        pos = (index >> 5 * (level - 1)) & 31;
-        for(i = 0; i < 32; i++)
-            if(i == pos)
-                update(index, value, old_root->succ[i], new_root->succ[i], level - 1);
-            else
-                new_root->succ[i] = old_root->succ[i];
+        leaf = copy_leaf(old_root->leaves[pos], 32, 0);
+        leaf->values[index & 31] = value;
+        release(new_root->leaves[pos]);
+        new_root->leaves[pos] = leaf;
     }
+    return new_root;
 }
 
 template<typename T>
 PersistentVector<T> PersistentVector<T>::append(T value) const
 {
-    int temp = elements_count;
-    PersistentVector<T> result;
-    while(temp != 0 && (temp & 31) == 0)
-        temp >>= 5;
-    if(temp == 1)
+    Node<T> *new_root = NULL;
+    Leaf<T> *leaf;
+    int count = elements_count - tail_offset(), expected = count, new_depth = depth;
+    if(elements_count > 0 && count < 32)
     {
-        result.root = new Node<T>;
-        result.root->succ[0] = root;
-        append(value, NULL, result.root->succ[1],  depth);
-        result.depth = depth + 1;
+        if(tail->filled.compare_exchange_strong(expected, count + 1))
+            leaf = acquire(tail);
+        else
+        {
+            leaf = copy_leaf(tail, count, 0);
+            leaf->filled = count + 1;
+        }
+        leaf->values[count] = value;
+        return PersistentVector(acquire(root), leaf, elements_count + 1, depth);
     }
-    else
+    if(elements_count > 0)
     {
-        append(value, root, result.root, depth);
-        result.depth = depth;
+        // The tail is full and moves to the trie.
+        if(root == NULL)
+        {
+            new_root = new_path(tail, 1, 0);
+            new_depth = 1;
+        }
+        else if((tail_offset() >> 5) >> 5 * depth != 0)
+        {
+            new_root = new_node(0);
+            new_root->nodes[0] = acquire(root);
+            new_root->nodes[1] = new_path(tail, depth, 0);
+            new_root->filled = 2;
+            new_depth = depth + 1;
+        }
+        else
+            new_root = push_leaf(root, tail, tail_offset() >> 5, depth);
     }
-    result.elements_count = elements_count + 1;
-    return result;
+    leaf = new_leaf(0);
+    leaf->values[0] = value;
+    leaf->filled.store(1, std::memory_order_relaxed);
+    return PersistentVector(new_root, leaf, elements_count + 1, new_depth);
 }
 
+// A chain of *level* new nodes of *owner* ending in *leaf*.
 template<typename T>
-void PersistentVector<T>::append(const T &value, Node<T> *old_root, Node<T> *&new_root, int level) const
+Node<T> *PersistentVector<T>::new_path(Leaf<T> *leaf, int level, unsigned long long owner) const
 {
-    int pos, i;
-    new_root = new Node<T>;
-    if(level == 0)
-        new_root->value = value;
+    Node<T> *node = new_node(owner);
+    if(level == 1)
+        node->leaves[0] = acquire(leaf);
     else
-    {
-        pos = (elements_count >> 5 * (level - 1)) & 31;
-        if(old_root != NULL)
-            for(i = 0; i < 32; i++)
-                if(i == pos)
-                    append(value, old_root->succ[i], new_root->succ[i], level - 1);
-                else
-                    new_root->succ[i] = old_root->succ[i];
-        else
-            append(value, NULL, new_root->succ[pos], level - 1);
-    }
+        node->nodes[0] = new_path(leaf, level - 1, owner);
+    node->filled.store(1, std::memory_order_relaxed);
+    return node;
 }
 
+// Adds *leaf* as leaf number *leaf_index*, right after the last one. Nodes are
+// only copied if another version has already used the slot.
 template<typename T>
-PersistentVector<T> PersistentVector<T>::pop() const
+Node<T> *PersistentVector<T>::push_leaf(Node<T> *node, Leaf<T> *leaf, int leaf_index, int level) const
 {
-    int temp = elements_count - 1;
-    PersistentVector<T> result;
-    while(temp != 0 && (temp & 31) == 0)
-        temp >>= 5;
-    if(temp == 1)
+    Node<T> *child = NULL, *result;
+    int pos = (leaf_index >> 5 * (level - 1)) & 31, expected = pos;
+    if(level > 1 && (leaf_index & ((1 << 5 * (level - 1)) - 1)) != 0)
     {
-        result.root = root->succ[0];
-        result.depth = depth - 1;
+        // The leaf goes into the last child, which already has leaves.
+        child = push_leaf(node->nodes[pos], leaf, leaf_index, level - 1);
+        if(child == node->nodes[pos])
+        {
+            release(child, level - 1);
+            return acquire(node);
+        }
+        result = copy_node(node, pos, level, 0);
+        result->nodes[pos] = child;
+        result->filled = pos + 1;
+        return result;
     }
+    if(level > 1)
+        child = new_path(leaf, level - 1, 0);
+    if(node->filled.compare_exchange_strong(expected, pos + 1))
+        result = acquire(node);
     else
     {
-        pop(root, result.root, depth);
-        result.depth = depth;
+        result = copy_node(node, pos, level, 0);
+        result->filled = pos + 1;
     }
-    result.elements_count = elements_count - 1;
+    if(level == 1)
+        result->leaves[pos] = acquire(leaf);
+    else
+        result->nodes[pos] = child;
     return result;
 }
 
 template<typename T>
-void PersistentVector<T>::pop(Node<T> *old_root, Node<T> *&new_root, int level) const
+PersistentVector<T> PersistentVector<T>::pop() const
 {
-    int pos, i;
-    if(level != 0 && (elements_count - 1 & (1 << 5 * level) - 1) != 0)
+    Node<T> *node = root, *new_root = root;
+    int last, level, new_depth = depth;
+    if(elements_count == 1)
+        return PersistentVector<T>();
+    if(elements_count - tail_offset() > 1)
+        return PersistentVector(acquire(root), acquire(tail), elements_count - 1, depth);
+    // The tail becomes empty; the last leaf of the trie becomes the tail. It
+    // stays in the trie too, where the smaller version does not look for it.
+    last = (tail_offset() >> 5) - 1;
+    for(level = depth; level > 1; level--)
+        node = node->nodes[(last >> 5 * (level - 1)) & 31];
+    if(last == 0)
     {
-        new_root = new Node<T>;
-        pos = (elements_count - 1 >> 5 * (level - 1)) & 31;
-        for(i = 0; i < 32; i++)
-            if(i == pos)
-                pop(old_root->succ[i], new_root->succ[i], level - 1);
-            else
-                new_root->succ[i] = old_root->succ[i];
+        new_root = NULL;
+        new_depth = 0;
     }
+    while(new_depth > 1 && (last - 1) >> 5 * (new_depth - 1) == 0)
+    {
+        new_root = new_root->nodes[0];
+        new_depth--;
+    }
+    return PersistentVector(acquire(new_root), acquire(node->leaves[last & 31]), elements_count - 1, new_depth);
 }
 
 template<typename T>
@@ -190,3 +511,332 @@ int PersistentVector<T>::size() const
     return elements_count;
 }
 
+template<typename T>
+class TransientVector {
+public:
+    // Starts with the elements of *vector*, which doesn't change.
+    TransientVector(const PersistentVector<T> &vector);
+
+    // Returns the value of the element at position *index*.
+    T operator[](int index) const;
+
+    // Replaces the element at position *index* by *value*.
+    void update(int index, T value);
+
+    // Appends *value* at the end.
+    void append(T value);
+
+    // Removes the last element.
+    void pop();
+
+    int size() const;
+
+    // Returns a persistent vector with the elements in O(1). The transient
+    // vector can't be changed after that.
+    PersistentVector<T> persistent();
+
+private:
+    PersistentVector<T> vector;
+
+    // The tag of the leaves and nodes this vector may change, 0 after persistent().
+    unsigned long long owner;
+
+    // The last tag given to a transient vector.
+    static std::atomic<unsigned long long> owners_count;
+
+    TransientVector(const TransientVector &);
+
+    TransientVector &operator=(const TransientVector &);
+
+    void check_owner() const;
+
+    void make_editable(Leaf<T> *&, int);
+
+    void make_editable(Node<T> *&, int, int);
+
+    void push_leaf(Node<T> *&, Leaf<T> *, int, int);
+};
+
+template<typename T>
+std::atomic<unsigned long long> TransientVector<T>::owners_count(0);
+
+template<typename T>
+TransientVector<T>::TransientVector(const PersistentVector<T> &vector)
+{
+    this->vector = vector;
+    owner = ++owners_count;
+}
+
+template<typename T>
+void TransientVector<T>::check_owner() const
+{
+    if(owner == 0)
+        throw std::logic_error("TransientVector changed after persistent()");
+}
+
+// Replaces *leaf* by a copy of its first *count* values that this vector owns,
+// unless it already owns it.
+template<typename T>
+void TransientVector<T>::make_editable(Leaf<T> *&leaf, int count)
+{
+    Leaf<T> *copy;
+    if(leaf->owner == owner)
+        return;
+    copy = PersistentVector<T>::copy_leaf(leaf, count, owner);
+    PersistentVector<T>::release(leaf);
+    leaf = copy;
+}
+
+template<typename T>
+void TransientVector<T>::make_editable(Node<T> *&node, int count, int level)
+{
+    Node<T> *copy;
+    if(node->owner == owner)
+        return;
+    copy = PersistentVector<T>::copy_node(node, count, level, owner);
+    PersistentVector<T>::release(node, level);
+    node = copy;
+}
+
+template<typename T>
+T TransientVector<T>::operator[](int index) const
+{
+    return vector[index];
+}
+
+template<typename T>
+void TransientVector<T>::update(int index, T value)
+{
+    Node<T> *node;
+    int level, pos;
+    check_owner();
+    if(index >= vector.tail_offset())
+    {
+        make_editable(vector.tail, vector.elements_count - vector.tail_offset());
+        vector.tail->values[index & 31] = value;
+        return;
+    }
+    make_editable(vector.root, vector.visible_slots(index, vector.depth), vector.depth);
+    node = vector.root;
+    for(level = vector.depth; level > 1; level--)
+    {
+        pos = (index >> 5 * level) & 31;
+        make_editable(node->nodes[pos], vector.visible_slots(index, level - 1), level - 1);
+        node = node->nodes[pos];
+    }
+    pos = (index >> 5) & 31;
+    make_editable(node->leaves[pos], 32);
+    node->leaves[pos]->values[index & 31] = value;
+}
+
+template<typename T>
+void TransientVector<T>::append(T value)
+{
+    int count = vector.elements_count - vector.tail_offset(), leaf_index;
+    Node<T> *root;
+    check_owner();
+    if(vector.elements_count > 0 && count < 32)
+    {
+        make_editable(vector.tail, count);
+        vector.tail->values[count] = value;
+        if(vector.tail->filled.load(std::memory_order_relaxed) <= count)
+            vector.tail->filled.store(count + 1, std::memory_order_relaxed);
+        vector.elements_count++;
+        return;
+    }
+    if(vector.elements_count > 0)
+    {
+        leaf_index = vector.tail_offset() >> 5;
+        if(vector.root == NULL)
+        {
+            vector.root = vector.new_path(vector.tail, 1, owner);
+            vector.depth = 1;
+        }
+        else if(leaf_index >> 5 * vector.depth != 0)
+        {
+            root = PersistentVector<T>::new_node(owner);
+            root->nodes[0] = vector.root;
+            root->nodes[1] = vector.new_path(vector.tail, vector.depth, owner);
+            root->filled = 2;
+            vector.root = root;
+            vector.depth++;
+        }
+        else
+            push_leaf(vector.root, vector.tail, leaf_index, vector.depth);
+        PersistentVector<T>::release(vector.tail);
+    }
+    vector.tail = PersistentVector<T>::new_leaf(owner);
+    vector.tail->values[0] = value;
+    vector.tail->filled.store(1, std::memory_order_relaxed);
+    vector.elements_count++;
+}
+
+// Adds *leaf* as leaf number *leaf_index*, right after the last one, to the
+// subtree of *node*, which is replaced by a copy if this vector doesn't own it.
+template<typename T>
+void TransientVector<T>::push_leaf(Node<T> *&node, Leaf<T> *leaf, int leaf_index, int level)
+{
+    Node<T> *child;
+    int pos = (leaf_index >> 5 * (level - 1)) & 31;
+    if(level > 1 && (leaf_index & ((1 << 5 * (level - 1)) - 1)) != 0)
+    {
+        make_editable(node, pos + 1, level);
+        push_leaf(node->nodes[pos], leaf, leaf_index, level - 1);
+        return;
+    }
+    make_editable(node, pos, level);
+    // A slot past the end may still hold a leaf or node that was popped.
+    if(level == 1)
+    {
+        PersistentVector<T>::acquire(leaf);
+        if(pos < node->filled)
+            PersistentVector<T>::release(node->leaves[pos]);
+        node->leaves[pos] = leaf;
+    }
+    else
+    {
+        child = vector.new_path(leaf, level - 1, owner);
+        if(pos < node->filled)
+            PersistentVector<T>::release(node->nodes[pos], level - 1);
+        node->nodes[pos] = child;
+    }
+    if(node->filled <= pos)
+        node->filled = pos + 1;
+}
+
+// Nothing is allocated, so this is the same as for persistent vectors.
+template<typename T>
+void TransientVector<T>::pop()
+{
+    check_owner();
+    vector = vector.pop();
+}
+
+template<typename T>
+int TransientVector<T>::size() const
+{
+    return vector.size();
+}
+
+template<typename T>
+PersistentVector<T> TransientVector<T>::persistent()
+{
+    check_owner();
+    owner = 0;
+    return vector;
+}
+
+const int NUM_ELEMENTS = 100000000;
+const int NUM_OPERATIONS = 1 << 20;
+// The soak keeps the last SOAK_VERSIONS versions of a vector of about
+// SOAK_ELEMENTS elements alive; every cycle makes a new version from the
+// latest one and drops the oldest.
+const int SOAK_ELEMENTS = 1 << 20;
+const int SOAK_VERSIONS = 1024;
+const int SOAK_ROUNDS = 8;
+const int SOAK_CYCLES = 1 << 18;
+const int SOAK_UPDATES = 4;
+
+unsigned state = 42;
+
+int rand30()
+{
+    state = state * 1103515245 + 12345;
+    return state >> 2;
+}
+
+// Memory has to stay flat: every dropped version gives its unique leaves and
+// nodes back to the pool, and new versions reuse them.
+void soak()
+{
+    TransientVector<int> transient((PersistentVector<int>()));
+    std::vector<PersistentVector<int> > versions;
+    PersistentVector<int> version;
+    long long checksum = 0;
+    struct rusage usage;
+    int round, cycle, i;
+
+    for(i = 0; i < SOAK_ELEMENTS; i++)
+        transient.append(i);
+    version = transient.persistent();
+    versions.assign(SOAK_VERSIONS, version);
+    for(round = 1; round <= SOAK_ROUNDS; round++)
+    {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        for(cycle = 0; cycle < SOAK_CYCLES; cycle++)
+        {
+            for(i = 0; i < SOAK_UPDATES; i++)
+                version = version.update(rand30() % version.size(), cycle);
+            if(cycle % 16 == 0)
+                version = version.size() > SOAK_ELEMENTS ? version.pop() : version.append(cycle);
+            // Somebody still reads an old version.
+            checksum += versions[rand30() % SOAK_VERSIONS][rand30() % SOAK_ELEMENTS];
+            versions[cycle % SOAK_VERSIONS] = version;
+        }
+        double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        getrusage(RUSAGE_SELF, &usage);
+        fprintf(stdout, "soak round %d: %d cycles in %.3lfs, node pools %.1lf MB, peak resident set size %.1lf MB\n",
+            round, SOAK_CYCLES, elapsed, PersistentVector<int>::pool_bytes() / 1048576.0, usage.ru_maxrss / 1024.0);
+    }
+    fprintf(stdout, "soak checksum %lld\n", checksum);
+}
+
+int main()
+{
+    PersistentVector<int> vector, built, updated, updated_in_place;
+    TransientVector<int> transient(built);
+    std::vector<int> indices(NUM_OPERATIONS);
+    struct rusage usage;
+    long long checksum = 0;
+    bool same = true;
+    int i;
+
+    soak();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for(i = 0; i < NUM_ELEMENTS; i++)
+        vector = vector.append(i);
+    double append_elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    getrusage(RUSAGE_SELF, &usage);
+    fprintf(stdout, "%d appends: %.3lfs (%.2lf Mops/s), peak resident set size %.1lf MB (%.2lf bytes per element)\n",
+        NUM_ELEMENTS, append_elapsed, NUM_ELEMENTS / append_elapsed / 1e6, usage.ru_maxrss / 1024.0,
+        usage.ru_maxrss * 1024.0 / NUM_ELEMENTS);
+    start = std::chrono::steady_clock::now();
+    for(i = 0; i < NUM_ELEMENTS; i++)
+        transient.append(i);
+    built = transient.persistent();
+    double transient_append_elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    fprintf(stdout, "%d transient appends: %.3lfs (%.2lf Mops/s)\n",
+        NUM_ELEMENTS, transient_append_elapsed, NUM_ELEMENTS / transient_append_elapsed / 1e6);
+
+    for(i = 0; i < NUM_OPERATIONS; i++)
+        indices[i] = rand30() % NUM_ELEMENTS;
+    start = std::chrono::steady_clock::now();
+    for(i = 0; i < NUM_OPERATIONS; i++)
+        checksum += vector[indices[i]];
+    double read_elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    updated = vector;
+    start = std::chrono::steady_clock::now();
+    for(i = 0; i < NUM_OPERATIONS; i++)
+        updated = updated.update(indices[i], i);
+    double update_elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    start = std::chrono::steady_clock::now();
+    TransientVector<int> updater(built);
+    for(i = 0; i < NUM_OPERATIONS; i++)
+        updater.update(indices[i], i);
+    updated_in_place = updater.persistent();
+    double transient_update_elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    for(i = 0; i < NUM_OPERATIONS; i++)
+        if(updated[indices[i]] != updated_in_place[indices[i]] || built[indices[i]] != indices[i])
+            same = false;
+    fprintf(stdout, "%d reads: %.3lfs (%.2lf Mops/s), checksum %lld\n",
+        NUM_OPERATIONS, read_elapsed, NUM_OPERATIONS / read_elapsed / 1e6, checksum);
+    fprintf(stdout, "%d updates: %.3lfs (%.2lf Mops/s), transient updates: %.3lfs (%.2lf Mops/s), %s\n",
+        NUM_OPERATIONS, update_elapsed, NUM_OPERATIONS / update_elapsed / 1e6, transient_update_elapsed,
+        NUM_OPERATIONS / transient_update_elapsed / 1e6, same ? "same" : "DIFFERENT");
+    start = std::chrono::steady_clock::now();
+    for(i = 0; i < NUM_OPERATIONS; i++)
+        updated = updated.pop();
+    double pop_elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    fprintf(stdout, "%d pops: %.3lfs (%.2lf Mops/s)\n", NUM_OPERATIONS, pop_elapsed, NUM_OPERATIONS / pop_elapsed / 1e6);
+    return 0;
+}
@@ -0,0 +1,47 @@
+/**
+* Element type for the heaps that splits a priority from its payload.
+*
+* Only the priority is compared, so a heap of Prioritized<Priority, Payload>
+* orders its elements by priority alone and never looks at the payload. With
+* emplace the payload is built in place inside the heap node, extractMin moves
+* it out again, and decreasePriority changes the priority without touching it,
+* so a payload is constructed once and moved once over its life in the heap.
+*/
+
+#ifndef __PRIORITIZED_H__
+#define __PRIORITIZED_H__
+
+#include <utility>
+
+template <class Priority, class Payload> struct Prioritized
+{
+	Priority priority;
+	Payload payload;
+
+	Prioritized() : priority(), payload()
+	{
+	}
+
+	// The payload is constructed from the remaining arguments.
+	template <class... Args> Prioritized(const Priority &priority, Args&&... args)
+		: priority(priority), payload(std::forward<Args>(args)...)
+	{
+	}
+
+	bool operator<(const Prioritized &other) const
+	{
+		return priority < other.priority;
+	}
+
+	bool operator>(const Prioritized &other) const
+	{
+		return other.priority < priority;
+	}
+
+	bool operator<=(const Prioritized &other) const
+	{
+		return !(other.priority < priority);
+	}
+};
+
+#endif // #ifndef __PRIORITIZED_H__
@@ -0,0 +1,209 @@
+/**
+* Monotone radix heap for unsigned integer keys.
+*
+* Keys are kept in buckets by the highest bit in which they differ from the
+* last extracted key: bucket 0 holds keys equal to it, bucket b holds keys
+* whose highest differing bit is b - 1. extractMin empties the lowest
+* non-empty bucket into lower ones, so every element moves down at most once
+* per bit and all operations take O(log C) amortized time for keys below C.
+*
+* The heap is monotone: inserted and decreased keys must not be smaller than
+* the last extracted key, which holds for Dijkstra with non-negative weights.
+* The interface follows FibonacciHeap, with integer handles as in DaryHeap.
+*/
+
+#ifndef __RADIX_HEAP_H__
+#define __RADIX_HEAP_H__
+
+#include <cstdlib>
+#include <type_traits>
+#include <vector>
+
+template <class T> class RadixHeap
+{
+	static_assert(std::is_integral<T>::value && std::is_unsigned<T>::value,
+		"RadixHeap can only be used with unsigned integral keys.");
+
+public:
+	RadixHeap();
+	int insert(const T &);
+	T getMin() const;
+	T extractMin();
+	// Same as extractMin, also storing the handle of the extracted element.
+	T extractMin(int &handle);
+	// Every key of the merged heap must not be smaller than the last key
+	// extracted from this one. Returns the offset to add to its handles.
+	int merge(RadixHeap<T> &);
+	void decreaseKey(int, const T &);
+	int getSize() const;
+
+private:
+	static const int BUCKETS = sizeof(T) * 8 + 1;
+
+	// Handles of the elements in each bucket.
+	std::vector<int> buckets[BUCKETS];
+	// Key, bucket and index inside the bucket of each handle.
+	std::vector<T> keys;
+	std::vector<int> bucket_of, index_of;
+	std::vector<int> free_handles;
+	T last;
+	int size;
+	int bucket(const T &) const;
+	void add_to_bucket(int);
+	void remove_from_bucket(int);
+	int lowest_bucket() const;
+};
+
+template <class T> RadixHeap<T>::RadixHeap()
+{
+	last = 0;
+	size = 0;
+}
+
+template <class T> int RadixHeap<T>::bucket(const T &key) const
+{
+	T diff = key ^ last;
+	if (diff == 0)
+		return 0;
+#ifdef __GNUC__
+	return 64 - __builtin_clzll((unsigned long long)diff);
+#else
+	int result = 0;
+	while (diff != 0)
+	{
+		diff >>= 1;
+		result++;
+	}
+	return result;
+#endif
+}
+
+template <class T> void RadixHeap<T>::add_to_bucket(int handle)
+{
+	int b = bucket(keys[handle]);
+	bucket_of[handle] = b;
+	index_of[handle] = buckets[b].size();
+	buckets[b].push_back(handle);
+}
+
+template <class T> void RadixHeap<T>::remove_from_bucket(int handle)
+{
+	std::vector<int> &b = buckets[bucket_of[handle]];
+	int moved = b.back();
+	b[index_of[handle]] = moved;
+	index_of[moved] = index_of[handle];
+	b.pop_back();
+}
+
+template <class T> int RadixHeap<T>::lowest_bucket() const
+{
+	int b = 0;
+	while (buckets[b].empty())
+		b++;
+	return b;
+}
+
+template <class T> int RadixHeap<T>::insert(const T &key)
+{
+	int handle;
+	if (free_handles.empty())
+	{
+		handle = keys.size();
+		keys.push_back(key);
+		bucket_of.push_back(0);
+		index_of.push_back(0);
+	}
+	else
+	{
+		handle = free_handles.back();
+		free_handles.pop_back();
+		keys[handle] = key;
+	}
+	add_to_bucket(handle);
+	size++;
+	return handle;
+}
+
+template <class T> T RadixHeap<T>::getMin() const
+{
+	const std::vector<int> &b = buckets[lowest_bucket()];
+	T result = keys[b[0]];
+	int i;
+	for (i = 1; i < (int)b.size(); i++)
+		if (result > keys[b[i]])
+			result = keys[b[i]];
+	return result;
+}
+
+template <class T> T RadixHeap<T>::extractMin()
+{
+	int handle;
+	return extractMin(handle);
+}
+
+template <class T> T RadixHeap<T>::extractMin(int &handle)
+{
+	int b, i;
+	if (buckets[0].empty())
+	{
+		b = lowest_bucket();
+		std::vector<int> &split = buckets[b];
+		last = keys[split[0]];
+		for (i = 1; i < (int)split.size(); i++)
+			if (last > keys[split[i]])
+				last = keys[split[i]];
+		// Relative to the new last key every element of the bucket lands in a
+		// lower one.
+		for (i = 0; i < (int)split.size(); i++)
+			add_to_bucket(split[i]);
+		split.clear();
+	}
+	handle = buckets[0].back();
+	buckets[0].pop_back();
+	free_handles.push_back(handle);
+	size--;
+	return last;
+}
+
+template <class T> int RadixHeap<T>::merge(RadixHeap<T> &rh)
+{
+	int offset = keys.size(), handle, i, b;
+	keys.insert(keys.end(), rh.keys.begin(), rh.keys.end());
+	bucket_of.resize(keys.size());
+	index_of.resize(keys.size());
+	for (b = 0; b < BUCKETS; b++)
+		for (i = 0; i < (int)rh.buckets[b].size(); i++)
+		{
+			handle = rh.buckets[b][i] + offset;
+			add_to_bucket(handle);
+		}
+	for (i = 0; i < (int)rh.free_handles.size(); i++)
+		free_handles.push_back(rh.free_handles[i] + offset);
+	size += rh.size;
+	for (b = 0; b < BUCKETS; b++)
+		rh.buckets[b].clear();
+	rh.keys.clear();
+	rh.bucket_of.clear();
+	rh.index_of.clear();
+	rh.free_handles.clear();
+	rh.last = 0;
+	rh.size = 0;
+	return offset;
+}
+
+template <class T> void RadixHeap<T>::decreaseKey(int handle, const T &new_key)
+{
+	if (keys[handle] > new_key)
+	{
+		remove_from_bucket(handle);
+		keys[handle] = new_key;
+		add_to_bucket(handle);
+	}
+}
+
+template <class T> int RadixHeap<T>::getSize() const
+{
+	return size;
+}
+
+#endif // #ifndef __RADIX_HEAP_H__
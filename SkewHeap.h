@@ -0,0 +1,258 @@
+#ifndef __SKEW_HEAP_H__
+#define __SKEW_HEAP_H__
+
+#include <cstdlib>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "NodePool.h"
+
+/*
+* Data type that represents a template of min-heap implementation of Skew heap data stucture
+*
+* Nodes are obtained from @Allocator, see NodePool.h.
+*/
+template<typename T, template <typename> class Allocator = NodePool>
+class SkewHeap
+{
+public:
+	SkewHeap()
+	{
+		root = NULL;
+		size = 0;
+	}
+
+	~SkewHeap()
+	{
+		if (!Allocator<Node>::releases_in_bulk || !std::is_trivially_destructible<T>::value)
+			deleteSubtree(root);
+	}
+
+	/*
+	* Method that adds a node with data provided by @value in the current skew heap.
+	*
+	* @param value: value to be added in the heap
+	*/
+	void add(const T& value)
+	{
+		emplace(value);
+	}
+
+	/*
+	* Method that adds a node with data provided by @value in the current skew heap,
+	* moving the value into the node.
+	*
+	* @param value: value to be added in the heap
+	*/
+	void add(T&& value)
+	{
+		emplace(std::move(value));
+	}
+
+	/*
+	* Method that adds a node with data constructed in place from @args in the current skew heap.
+	*
+	* @param args: arguments passed to the constructor of the value
+	*/
+	template<typename... Args>
+	void emplace(Args&&... args)
+	{
+		Node *newNode = allocator.allocate(std::forward<Args>(args)...);
+		root = merge(root, newNode);
+		size++;
+	}
+
+	/*
+	* Method that adds all values in the range [@first, @last) in the current skew heap.
+	* The values are turned into single-node heaps that are merged pairwise,
+	* round by round, which takes O(k) time for k values instead of O(k log n).
+	*
+	* @param first: iterator to the first value to be added
+	* @param last: iterator past the last value to be added
+	*/
+	template<typename InputIterator>
+	void addRange(InputIterator first, InputIterator last)
+	{
+		std::vector<Node*> queue;
+		int count, i, j;
+		for (; first != last; ++first)
+			queue.push_back(allocator.allocate(*first));
+		count = queue.size();
+		size += count;
+		// Each round merges neighbours in place, halving the number of heaps.
+		while (count > 1)
+		{
+			for (i = 0, j = 0; i + 1 < count; i += 2)
+				queue[j++] = merge(queue[i], queue[i + 1]);
+			if (i < count)
+				queue[j++] = queue[i];
+			count = j;
+		}
+		if (count == 1)
+			root = merge(root, queue[0]);
+	}
+
+	/*
+	* This method removes and returns the smallest element in the current skew heap.
+	* The element is moved out of its node, not copied.
+	*
+	* @returns the removed element or throws exception if there are no any elements in the heap
+	*/
+	T removeMin()
+	{
+		T minValue = std::move(root->value);
+		Node* temp = root;
+		root = merge(root->left, root->right);
+		allocator.deallocate(temp);
+		size--;
+		return minValue;
+	}
+
+	/*
+	* Returns the smallest element in the current skew heap without removing it.
+	*/
+	const T& getMin() const
+	{
+		return root->value;
+	}
+
+	/*
+	* Tests whether there are any elements in the current heap.
+	*
+	* @returns true, if there are no any elements and false, otherwise
+	*/
+	bool empty() const
+	{
+		return size == 0;
+	}
+
+	/*
+	* Method that merges the current skew heap with the given by @other.
+	* This method destructs the @other skew heap while merging it.
+	*
+	* @param other: reference to the skew heap data structure that will be merged with the current one
+	*/
+	void merge(SkewHeap<T, Allocator>& other)
+	{
+		root = merge(root, other.root);
+		size += other.size;
+		allocator.adopt(other.allocator);
+		other.root = NULL;
+		other.size = 0;
+	}
+
+	/*
+	* Returns the number of requests the heap made to the system allocator.
+	*/
+	long long getAllocationCount() const
+	{
+		return allocator.getAllocationCount();
+	}
+
+	/*
+	* Returns the largest number of bytes of node memory the heap has held.
+	*/
+	long long getPeakNodeMemory() const
+	{
+		return allocator.getPeakBytes();
+	}
+
+private:
+	/*
+	* Data type that represents a node in the Skew heap
+	*/
+	class Node
+	{
+	public:
+		template<typename... Args>
+		explicit Node(Args&&... args)
+			: value(std::forward<Args>(args)...)
+		{
+			this->left = NULL;
+			this->right = NULL;
+		}
+
+		~Node()
+		{
+		}
+
+		T value; // data value
+		Node* left; // left subtree
+		Node* right; // right subtree
+	};
+
+	/*
+	* Frees all nodes of the subtree pointed to by @root without recursion:
+	* left children are rotated up until the leftmost node can be freed.
+	*/
+	void deleteSubtree(Node *root)
+	{
+		Node* temp;
+		while (root != NULL)
+		{
+			if (root->left != NULL)
+			{
+				temp = root->left;
+				root->left = temp->right;
+				temp->right = root;
+				root = temp;
+			}
+			else
+			{
+				temp = root->right;
+				allocator.deallocate(root);
+				root = temp;
+			}
+		}
+	}
+
+	/*
+	* Method that merges two skew heap data structures pointed to their roots by @root1 and @root2
+	*
+	* The merge walks down both right spines top-down: the smaller head is
+	* appended to the result, its children are swapped, and the merge goes on in
+	* its (new) left slot, so no recursion is needed.
+	*
+	* @param root1: pointer to the root of the first skew heap
+	* @param root2: pointer to the root of the second skew heap
+	*
+	* @returns a pointer to the root of the merged data structure
+	*/
+	Node* merge(Node* root1, Node* root2)
+	{
+		Node *result = NULL, **slot = &result, *temp;
+		while (root1 != NULL && root2 != NULL)
+		{
+			if (root2->value < root1->value)
+			{
+				temp = root1;
+				root1 = root2;
+				root2 = temp;
+			}
+			*slot = root1;
+			temp = root1->right;
+			root1->right = root1->left;
+			slot = &root1->left;
+			root1 = temp;
+		}
+		*slot = root1 != NULL ? root1 : root2;
+		return result;
+	}
+
+	/*
+	* Pointer to the root for the current skew heap
+	*/
+	Node* root;
+
+	int size;
+
+	/*
+	* Allocator owning the nodes of the current skew heap
+	*/
+	Allocator<Node> allocator;
+
+	SkewHeap(const SkewHeap&);
+	SkewHeap& operator=(const SkewHeap&);
+};
+
+#endif // #ifndef __SKEW_HEAP_H__
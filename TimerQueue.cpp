@@ -0,0 +1,337 @@
+#include <cstdio>
+#include <cstdlib>
+#include <algorithm>
+#include <chrono>
+#include <queue>
+#include <utility>
+#include <vector>
+#include "PairingHeap.h"
+#include "Prioritized.h"
+using namespace std;
+
+/**
+* Timer queue with cancellation, built on PairingHeap.
+*
+* Every timer is a node of the heap, keyed by its deadline, so a cancelled
+* timer is erased at once instead of staying in the heap as a tombstone
+* until its deadline passes. cancel and reschedule take O(log n) amortized
+* time; a later deadline is handled by increasePriority, an earlier one by
+* decreasePriority, and the payload is never copied.
+*
+* A Timer handle stays valid until the timer fires or is cancelled.
+*/
+template <class Payload> class TimerQueue
+{
+public:
+	typedef PairingHeapNode<Prioritized<long long, Payload> > *Timer;
+
+	TimerQueue();
+	// Constructs the payload of a timer firing at deadline from args.
+	template <class... Args> Timer schedule(long long deadline, Args&&... args);
+	void cancel(Timer);
+	void reschedule(Timer, long long deadline);
+	long long getDeadline(Timer) const;
+	// The deadline of the timer that fires next. The queue must not be empty.
+	long long nextDeadline() const;
+	bool empty() const;
+	int getSize() const;
+	// Moves the clock to now and calls fire(payload) for every timer with a
+	// deadline not after now, in order of deadline. Returns their number.
+	template <class Function> int advanceTo(long long now, Function fire);
+	long long getNow() const;
+	long long getPeakNodeMemory() const;
+
+private:
+	PairingHeap<Prioritized<long long, Payload> > heap;
+	long long now;
+	TimerQueue(const TimerQueue &);
+	TimerQueue &operator=(const TimerQueue &);
+};
+
+template <class Payload> TimerQueue<Payload>::TimerQueue()
+{
+	now = 0;
+}
+
+template <class Payload> template <class... Args>
+typename TimerQueue<Payload>::Timer TimerQueue<Payload>::schedule(long long deadline, Args&&... args)
+{
+	return heap.emplace(deadline, std::forward<Args>(args)...);
+}
+
+template <class Payload> void TimerQueue<Payload>::cancel(Timer timer)
+{
+	heap.erase(timer);
+}
+
+template <class Payload> void TimerQueue<Payload>::reschedule(Timer timer, long long deadline)
+{
+	if (deadline < timer->key.priority)
+		heap.decreasePriority(timer, deadline);
+	else
+		heap.increasePriority(timer, deadline);
+}
+
+template <class Payload> long long TimerQueue<Payload>::getDeadline(Timer timer) const
+{
+	return timer->key.priority;
+}
+
+template <class Payload> long long TimerQueue<Payload>::nextDeadline() const
+{
+	return heap.getMin().priority;
+}
+
+template <class Payload> bool TimerQueue<Payload>::empty() const
+{
+	return heap.getSize() == 0;
+}
+
+template <class Payload> int TimerQueue<Payload>::getSize() const
+{
+	return heap.getSize();
+}
+
+template <class Payload> template <class Function> int TimerQueue<Payload>::advanceTo(long long now, Function fire)
+{
+	int fired = 0;
+	this->now = now;
+	while (heap.getSize() > 0 && heap.getMin().priority <= now)
+	{
+		Prioritized<long long, Payload> timer = heap.extractMin();
+		fire(timer.payload);
+		fired++;
+	}
+	return fired;
+}
+
+template <class Payload> long long TimerQueue<Payload>::getNow() const
+{
+	return now;
+}
+
+template <class Payload> long long TimerQueue<Payload>::getPeakNodeMemory() const
+{
+	return heap.getPeakNodeMemory();
+}
+
+const int NUM_TIMERS = 1 << 20;
+// Timers are created one per tick and fire TIMEOUT ticks later.
+const int TIMEOUT = 1 << 18;
+const int CANCEL_PERCENT = 95;
+
+// Planned cancellations: the tick and the timer id, earliest first.
+typedef priority_queue<pair<long long, int>, vector<pair<long long, int> >, greater<pair<long long, int> > > Cancellations;
+
+// Decides for every timer whether and when it is cancelled, the same way for
+// both queues.
+void planCancellations(Cancellations &cancellations, long long tick, int id, unsigned &state)
+{
+	state = state * 1103515245 + 12345;
+	if ((int)((state >> 8) % 100) < CANCEL_PERCENT)
+		cancellations.push(make_pair(tick + (state >> 8) % TIMEOUT, id));
+}
+
+struct Fire
+{
+	vector<PairingHeapNode<Prioritized<long long, int> > *> *timers;
+	long long *fired;
+
+	void operator()(int id)
+	{
+		(*timers)[id] = NULL;
+		(*fired)++;
+	}
+};
+
+void benchmarkTimerQueue()
+{
+	TimerQueue<int> queue;
+	vector<TimerQueue<int>::Timer> timers(NUM_TIMERS, NULL);
+	Cancellations cancellations;
+	long long tick, fired = 0, cancelled = 0;
+	int peak = 0;
+	unsigned state = 42;
+	Fire fire = { &timers, &fired };
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for (tick = 0; tick < NUM_TIMERS || !queue.empty(); tick++)
+	{
+		if (tick < NUM_TIMERS)
+		{
+			timers[tick] = queue.schedule(tick + TIMEOUT, (int)tick);
+			planCancellations(cancellations, tick, tick, state);
+		}
+		while (!cancellations.empty() && cancellations.top().first <= tick)
+		{
+			queue.cancel(timers[cancellations.top().second]);
+			timers[cancellations.top().second] = NULL;
+			cancellations.pop();
+			cancelled++;
+		}
+		queue.advanceTo(tick, fire);
+		if (peak < queue.getSize())
+			peak = queue.getSize();
+	}
+	double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	fprintf(stdout, "timer queue: %.3lfs, %lld fired, %lld cancelled, peak %d timers in the heap, %.1lf MB of nodes\n",
+		elapsed, fired, cancelled, peak, queue.getPeakNodeMemory() / 1048576.0);
+}
+
+// The workaround the timer queue replaces: cancelled timers are only marked
+// and are dropped when they reach the top of the heap.
+void benchmarkTombstones()
+{
+	PairingHeap<pair<long long, int> > heap;
+	vector<bool> cancelled_ids(NUM_TIMERS, false);
+	Cancellations cancellations;
+	long long tick, fired = 0, cancelled = 0;
+	int peak = 0;
+	unsigned state = 42;
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for (tick = 0; tick < NUM_TIMERS || heap.getSize() > 0; tick++)
+	{
+		if (tick < NUM_TIMERS)
+		{
+			heap.insert(make_pair(tick + TIMEOUT, (int)tick));
+			planCancellations(cancellations, tick, tick, state);
+		}
+		while (!cancellations.empty() && cancellations.top().first <= tick)
+		{
+			cancelled_ids[cancellations.top().second] = true;
+			cancellations.pop();
+			cancelled++;
+		}
+		while (heap.getSize() > 0 && heap.getMin().first <= tick)
+			if (!cancelled_ids[heap.extractMin().second])
+				fired++;
+		if (peak < heap.getSize())
+			peak = heap.getSize();
+	}
+	double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	fprintf(stdout, "tombstones:  %.3lfs, %lld fired, %lld cancelled, peak %d timers in the heap, %.1lf MB of nodes\n",
+		elapsed, fired, cancelled, peak, heap.getPeakNodeMemory() / 1048576.0);
+}
+
+const int NUM_RESCHEDULED = 1 << 16;
+const int NUM_RESCHEDULE_TICKS = 1 << 19;
+const int RESCHEDULES_PER_TICK = 8;
+
+// The ticks and ids of the timers in the order they fired.
+typedef vector<pair<long long, int> > Firings;
+
+// A deadline between 1 and TIMEOUT ticks after tick.
+long long randomDeadline(long long tick, unsigned &state)
+{
+	state = state * 1103515245 + 12345;
+	return tick + 1 + (state >> 8) % TIMEOUT;
+}
+
+int randomTimer(unsigned &state)
+{
+	state = state * 1103515245 + 12345;
+	return (state >> 8) % NUM_RESCHEDULED;
+}
+
+struct Record
+{
+	Firings *fired;
+	long long tick;
+
+	void operator()(int id)
+	{
+		fired->push_back(make_pair(tick, id));
+	}
+};
+
+// Idle timeouts: every tick moves some random timers to a new deadline,
+// earlier or later than the old one, and a timer that fires is scheduled
+// again. The timers firing in the same tick are sorted by id, so that both
+// versions draw the same random numbers.
+double rescheduleTimerQueue(Firings &fired)
+{
+	TimerQueue<int> queue;
+	vector<TimerQueue<int>::Timer> timers(NUM_RESCHEDULED);
+	Record record = { &fired, 0 };
+	unsigned state = 42;
+	int i, id;
+	size_t done = 0;
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for (id = 0; id < NUM_RESCHEDULED; id++)
+		timers[id] = queue.schedule(randomDeadline(0, state), id);
+	for (record.tick = 1; record.tick <= NUM_RESCHEDULE_TICKS; record.tick++)
+	{
+		for (i = 0; i < RESCHEDULES_PER_TICK; i++)
+		{
+			id = randomTimer(state);
+			queue.reschedule(timers[id], randomDeadline(record.tick, state));
+		}
+		queue.advanceTo(record.tick, record);
+		sort(fired.begin() + done, fired.end());
+		for (; done < fired.size(); done++)
+			timers[fired[done].second] = queue.schedule(randomDeadline(record.tick, state), fired[done].second);
+	}
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+// The same with a binary heap that cannot move entries: a rescheduled timer
+// gets a new entry and the old one is skipped when it reaches the top.
+double rescheduleReference(Firings &fired)
+{
+	priority_queue<pair<long long, int>, vector<pair<long long, int> >, greater<pair<long long, int> > > heap;
+	vector<long long> deadlines(NUM_RESCHEDULED);
+	long long tick;
+	unsigned state = 42;
+	int i, id;
+	size_t done = 0;
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for (id = 0; id < NUM_RESCHEDULED; id++)
+	{
+		deadlines[id] = randomDeadline(0, state);
+		heap.push(make_pair(deadlines[id], id));
+	}
+	for (tick = 1; tick <= NUM_RESCHEDULE_TICKS; tick++)
+	{
+		for (i = 0; i < RESCHEDULES_PER_TICK; i++)
+		{
+			id = randomTimer(state);
+			deadlines[id] = randomDeadline(tick, state);
+			heap.push(make_pair(deadlines[id], id));
+		}
+		while (!heap.empty() && heap.top().first <= tick)
+		{
+			id = heap.top().second;
+			// A timer moved to the same deadline twice has two live entries.
+			if (heap.top().first == deadlines[id])
+			{
+				fired.push_back(make_pair(tick, id));
+				deadlines[id] = -1;
+			}
+			heap.pop();
+		}
+		sort(fired.begin() + done, fired.end());
+		for (; done < fired.size(); done++)
+		{
+			id = fired[done].second;
+			deadlines[id] = randomDeadline(tick, state);
+			heap.push(make_pair(deadlines[id], id));
+		}
+	}
+	return chrono::duration<double>(chrono::steady_clock::now() - start).count();
+}
+
+void benchmarkReschedule()
+{
+	Firings fired, expected;
+	double elapsed = rescheduleTimerQueue(fired), reference_elapsed = rescheduleReference(expected);
+	fprintf(stdout, "reschedule:  %.3lfs, %d rescheduled, %d fired, %s; lazy binary heap %.3lfs\n",
+		elapsed, NUM_RESCHEDULE_TICKS * RESCHEDULES_PER_TICK, (int)fired.size(),
+		fired == expected ? "same order as the reference" : "NOT THE ORDER OF THE REFERENCE", reference_elapsed);
+}
+
+int main()
+{
+	benchmarkTimerQueue();
+	benchmarkTombstones();
+	benchmarkReschedule();
+	return 0;
+}
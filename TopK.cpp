@@ -0,0 +1,199 @@
+#include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <utility>
+#include <vector>
+#include "SkewHeap.h"
+using namespace std;
+
+/**
+* Bounded container for the k smallest elements of a stream.
+*
+* The kept elements are stored in a SkewHeap ordered the other way round, so
+* its root is the largest kept element, the current k-th smallest. An element
+* that is not smaller than it is rejected after a single comparison; a smaller
+* one replaces it. Memory stays at k nodes however long the stream is, and
+* with a NodePool the replaced node is reused for the new element.
+*/
+template <class T, template <class> class Allocator = NodePool> class TopK
+{
+public:
+	TopK(int capacity);
+	// Returns true if the element was kept.
+	bool offer(const T &);
+	// Offers all elements of [first, last) and returns the number kept.
+	template <class InputIterator> int offer(InputIterator first, InputIterator last);
+	// The largest kept element, the one the next smaller offer replaces.
+	const T &getWorst() const;
+	int getSize() const;
+	// Removes all kept elements and returns them in increasing order.
+	vector<T> extractSorted();
+	long long getPeakNodeMemory() const;
+
+private:
+	// Inverts the order of T, turning the min-heap into a max-heap.
+	struct Reversed
+	{
+		T value;
+
+		Reversed(const T &value) : value(value)
+		{
+		}
+
+		bool operator<(const Reversed &other) const
+		{
+			return other.value < value;
+		}
+	};
+
+	SkewHeap<Reversed, Allocator> heap;
+	int capacity, size;
+	TopK(const TopK &);
+	TopK &operator=(const TopK &);
+};
+
+template <class T, template <class> class Allocator> TopK<T, Allocator>::TopK(int capacity)
+{
+	this->capacity = capacity;
+	size = 0;
+}
+
+template <class T, template <class> class Allocator> bool TopK<T, Allocator>::offer(const T &value)
+{
+	if (size == capacity)
+	{
+		if (size == 0 || !(value < heap.getMin().value))
+			return false;
+		heap.removeMin();
+		size--;
+	}
+	heap.emplace(value);
+	size++;
+	return true;
+}
+
+template <class T, template <class> class Allocator> template <class InputIterator>
+int TopK<T, Allocator>::offer(InputIterator first, InputIterator last)
+{
+	vector<T> fill;
+	int kept = 0;
+	// While the container is filling up every element is kept, so they are
+	// added together with addRange in O(k) instead of one merge each.
+	for (; first != last && size + (int)fill.size() < capacity; ++first)
+		fill.push_back(*first);
+	if (!fill.empty())
+	{
+		heap.addRange(fill.begin(), fill.end());
+		size += fill.size();
+		kept += fill.size();
+	}
+	if (size == 0)
+		return kept;
+	// The threshold only changes when an element is kept, so the common
+	// rejection path reads nothing but a cached copy of it.
+	T worst = heap.getMin().value;
+	for (; first != last; ++first)
+		if (*first < worst)
+		{
+			heap.removeMin();
+			heap.emplace(*first);
+			worst = heap.getMin().value;
+			kept++;
+		}
+	return kept;
+}
+
+template <class T, template <class> class Allocator> const T &TopK<T, Allocator>::getWorst() const
+{
+	return heap.getMin().value;
+}
+
+template <class T, template <class> class Allocator> int TopK<T, Allocator>::getSize() const
+{
+	return size;
+}
+
+template <class T, template <class> class Allocator> vector<T> TopK<T, Allocator>::extractSorted()
+{
+	vector<T> result;
+	int i;
+	result.reserve(size);
+	for (i = 0; i < size; i++)
+		result.push_back(std::move(heap.removeMin().value));
+	size = 0;
+	// The heap hands out the largest element first.
+	for (i = 0; i < (int)result.size() / 2; i++)
+		swap(result[i], result[result.size() - 1 - i]);
+	return result;
+}
+
+template <class T, template <class> class Allocator> long long TopK<T, Allocator>::getPeakNodeMemory() const
+{
+	return heap.getPeakNodeMemory();
+}
+
+const int K = 1024;
+const int BATCH = 4096;
+const long long MAX_STREAM = 1LL << 28;
+// The unbounded heap keeps every element, so it is only run on short streams.
+const long long MAX_UNBOUNDED = 1LL << 22;
+
+// Scores of the stream come from a linear congruential generator, so the
+// stream never has to be stored.
+struct Stream
+{
+	unsigned state;
+
+	Stream() : state(42)
+	{
+	}
+
+	int next()
+	{
+		state = state * 1103515245 + 12345;
+		return state >> 1;
+	}
+};
+
+void benchmark(long long length)
+{
+	TopK<int> single(K), batched(K);
+	SkewHeap<int> unbounded;
+	Stream stream;
+	vector<int> batch(BATCH);
+	long long i;
+	int j;
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	for (i = 0; i < length; i++)
+		single.offer(stream.next());
+	double single_elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	stream = Stream();
+	start = chrono::steady_clock::now();
+	for (i = 0; i < length; i += BATCH)
+	{
+		for (j = 0; j < BATCH; j++)
+			batch[j] = stream.next();
+		batched.offer(batch.begin(), batch.end());
+	}
+	double batched_elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+	fprintf(stdout, "stream %11lld: offer %.3lfs, offer(range) %.3lfs, k-th smallest %d, peak node memory %.1lf KB",
+		length, single_elapsed, batched_elapsed, batched.getWorst(), batched.getPeakNodeMemory() / 1024.0);
+	if (length <= MAX_UNBOUNDED)
+	{
+		stream = Stream();
+		for (i = 0; i < length; i++)
+			unbounded.add(stream.next());
+		fprintf(stdout, ", unbounded heap %.1lf KB", unbounded.getPeakNodeMemory() / 1024.0);
+	}
+	fprintf(stdout, "\n");
+	if (single.extractSorted() != batched.extractSorted())
+		fprintf(stdout, "offer and offer(range) kept different elements\n");
+}
+
+int main()
+{
+	long long length;
+	for (length = 1 << 16; length <= MAX_STREAM; length <<= 2)
+		benchmark(length);
+	return 0;
+}